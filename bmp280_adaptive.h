@@ -0,0 +1,243 @@
+/**
+ * @file bmp280_adaptive.h
+ * @author Denys Khmil
+ * @brief This file contents the adaptive oversampling/ODR controller
+ */
+#ifndef BMP280_ADAPTIVE
+#define BMP280_ADAPTIVE
+
+#include <stdint.h>
+#include "bmp_sample.h"
+#include "bmp280_model.h"
+
+/**
+ * @brief Normal mode configuration selected by the controller
+ * @note current_na is the average sensor current of the preset, 0 uses bmp280_averageCurrent()
+ */
+struct bmp280_preset{
+    uint8_t osrs_p;
+    uint8_t osrs_t;
+    uint8_t filter;
+    uint8_t t_sb;
+    uint32_t current_na;
+};
+
+/**
+ * @brief Energy and latency accounting of a controller run
+ * @note dynamic samples are those with |rate| above the up threshold, latency is the
+ *       75% IIR step response time of the preset active at that sample
+ */
+struct bmp280_adaptive_report{
+    uint32_t samples;
+    uint32_t switches;
+    uint64_t time_ms;
+    uint64_t charge_nams;
+    uint32_t dynamic_samples;
+    uint64_t dynamic_latency_ms;
+
+    uint32_t averageCurrent() const{ return this->time_ms ? (uint32_t)(this->charge_nams / this->time_ms) : 0; }
+    uint32_t dynamicLatency() const{ return this->dynamic_samples ? (uint32_t)(this->dynamic_latency_ms / this->dynamic_samples) : 0; }
+};
+
+/**
+ * @brief Closed-loop preset selection from the compensated pressure stream
+ * @param Sensor: type with settings(osrs_p, osrs_t, mode) and setConfig(t_sb, filter), e.g. bmp280.
+ *        A type with empty functions replays recorded traces on a host.
+ * @param MaxPresets: preset storage.
+ * @note Presets are ordered from lowest power to most responsive. The rate of change is the slope
+ *       between means of consecutive windows (window ms, at least one sample), so its noise does
+ *       not grow with the sample rate. Rate and rate noise are exponential averages in Q24.8 Pa/s.
+ *       The controller steps up when |rate| > up_rate + noise and down when |rate| + noise < down_rate,
+ *       each for hold windows in a row, one preset per step
+ */
+template<typename Sensor, uint8_t MaxPresets = 4>
+class bmp280_adaptive{
+public:
+    bmp280_adaptive(Sensor* _sensor, const bmp280_preset* _presets, uint8_t _count, uint32_t _up_rate, uint32_t _down_rate, uint16_t _hold, uint32_t _window = 1000){
+        this->sensor = _sensor;
+        this->count = (_count > MaxPresets) ? MaxPresets : _count;
+        for(uint8_t i = 0; i < this->count; i++){
+            this->presets[i] = _presets[i];
+            if(!this->presets[i].current_na){
+                this->presets[i].current_na = bmp280_averageCurrent(_presets[i].osrs_p, _presets[i].osrs_t, _presets[i].t_sb);
+            }
+        }
+        this->upRate = _up_rate;
+        this->downRate = _down_rate;
+        this->hold = _hold;
+        this->window = _window;
+        this->index = 0;
+        this->resetReport();
+        this->restart();
+    }
+
+    /**
+     * @brief Apply preset and restart rate tracking
+     */
+    void start(uint8_t preset){
+        this->index = (preset < this->count) ? preset : (uint8_t)(this->count - 1);
+        this->apply();
+        this->restart();
+    }
+
+    /**
+     * @brief Feed compensated sample
+     * @param sample: compensated values.
+     * @param elapsed_ms: time since the previous sample, 0 uses the period of the active preset.
+     * @retval Active preset index
+     */
+    uint8_t update(const bmp_sample* sample, uint32_t elapsed_ms = 0){
+        const bmp280_preset& preset = this->presets[this->index];
+        uint32_t period_ms = bmp280_samplePeriod(preset.osrs_p, preset.osrs_t, preset.t_sb) / 1000;
+        uint32_t dt = elapsed_ms ? elapsed_ms : (period_ms ? period_ms : 1);
+
+        this->stats.samples++;
+        this->stats.time_ms += dt;
+        this->stats.charge_nams += (uint64_t)preset.current_na * dt;
+        if(this->magnitude() > (int64_t)this->upRate){
+            this->stats.dynamic_samples++;
+            this->stats.dynamic_latency_ms += (uint64_t)bmp280_filterSettleSamples(preset.filter) * period_ms;
+        }
+
+        this->windowSum += sample->pressure;
+        this->windowCount++;
+        this->windowTime += dt;
+        if(this->windowTime < this->window) return this->index;
+
+        int64_t mean = (int64_t)(this->windowSum / this->windowCount);
+        uint32_t span = this->windowTime;
+        this->windowSum = 0;
+        this->windowCount = 0;
+        this->windowTime = 0;
+        if(!this->primed){
+            this->lastMean = mean;
+            this->lastSpan = span;
+            this->primed = 1;
+            return this->index;
+        }
+
+        // window means are taken at the window centers
+        int64_t rate = (mean - this->lastMean) * 2000 / (int64_t)(span + this->lastSpan);
+        this->lastMean = mean;
+        this->lastSpan = span;
+        int64_t residual = rate - this->rate;
+        this->rate += (rate - this->rate) / 2;
+        this->noise += ((residual < 0 ? -residual : residual) - this->noise) / 4;
+        this->decide();
+        return this->index;
+    }
+
+    /**
+     * @brief Active preset index
+     */
+    uint8_t active() const{
+        return this->index;
+    }
+
+    /**
+     * @brief Rate of change estimate (Q24.8 Pa/s)
+     */
+    int32_t rateOfChange() const{
+        return (int32_t)this->rate;
+    }
+
+    /**
+     * @brief Energy and latency accounting since the last resetReport()
+     */
+    const bmp280_adaptive_report& report() const{
+        return this->stats;
+    }
+
+    /**
+     * @brief Clear energy and latency accounting
+     */
+    void resetReport(){
+        this->stats.samples = 0;
+        this->stats.switches = 0;
+        this->stats.time_ms = 0;
+        this->stats.charge_nams = 0;
+        this->stats.dynamic_samples = 0;
+        this->stats.dynamic_latency_ms = 0;
+    }
+
+private:
+    void apply(){
+        const bmp280_preset& preset = this->presets[this->index];
+        this->sensor->setConfig(preset.t_sb, preset.filter);
+        this->sensor->settings(preset.osrs_p, preset.osrs_t, BMP280_MODE_NORMAL);
+    }
+
+    void switchPreset(){
+        this->apply();
+        this->upCount = 0;
+        this->downCount = 0;
+        this->stats.switches++;
+    }
+
+    void decide(){
+        int64_t magnitude = this->magnitude();
+        if(magnitude > (int64_t)this->upRate + this->noise){
+            this->upCount++;
+            this->downCount = 0;
+        }
+        else if(magnitude + this->noise < (int64_t)this->downRate){
+            this->downCount++;
+            this->upCount = 0;
+        }
+        else{
+            this->upCount = 0;
+            this->downCount = 0;
+        }
+
+        if(this->upCount >= this->hold && this->index + 1 < this->count){
+            this->index++;
+            this->switchPreset();
+        }
+        else if(this->downCount >= this->hold && this->index > 0){
+            this->index--;
+            this->switchPreset();
+        }
+    }
+
+    int64_t magnitude() const{
+        return (this->rate < 0) ? -this->rate : this->rate;
+    }
+
+    void restart(){
+        this->primed = 0;
+        this->windowSum = 0;
+        this->windowCount = 0;
+        this->windowTime = 0;
+        this->rate = 0;
+        this->noise = 0;
+        this->upCount = 0;
+        this->downCount = 0;
+    }
+
+    Sensor* sensor;
+    bmp280_preset presets[MaxPresets];
+    uint8_t count;
+    uint8_t index;
+
+    /*THRESHOLDS*/
+    uint32_t upRate;
+    uint32_t downRate;
+    uint16_t hold;
+
+    /*RATE TRACKING*/
+    uint32_t window;
+    uint8_t primed;
+    uint64_t windowSum;
+    uint32_t windowCount;
+    uint32_t windowTime;
+    int64_t lastMean;
+    uint32_t lastSpan;
+    int64_t rate;
+    int64_t noise;
+    uint16_t upCount;
+    uint16_t downCount;
+
+    bmp280_adaptive_report stats;
+};
+
+#endif
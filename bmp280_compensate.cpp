@@ -0,0 +1,103 @@
+/**
+ * @file bmp280_compensate.cpp
+ * @author Denys Khmil
+ * @brief This file contents the hardware independent bmp280/BME280 functions
+ */
+#include "bmp280_compensate.h"
+
+/**
+ * @brief Decode calibration registers
+ * @param regs: 24 bytes read from 0x88 (26 bytes up to 0xA1 for BME280).
+ * @param hum_regs: 7 bytes read from 0xE1 for BME280, 0 for bmp280.
+ * @param calib: decoded constants.
+ */
+void bmp280_parseCalibration(const uint8_t* regs, const uint8_t* hum_regs, bmp280_calib* calib){
+    calib->dig_T1 = uint16_t(regs[1] << 8)|uint16_t(regs[0]);
+    calib->dig_T2 = int16_t(uint16_t(regs[3] << 8)|uint16_t(regs[2]));
+    calib->dig_T3 = int16_t(uint16_t(regs[5] << 8)|uint16_t(regs[4]));
+    calib->dig_P1 = uint16_t(regs[7] << 8)|uint16_t(regs[6]);
+    calib->dig_P2 = int16_t(uint16_t(regs[9] << 8)|uint16_t(regs[8]));
+    calib->dig_P3 = int16_t(uint16_t(regs[11] << 8)|uint16_t(regs[10]));
+    calib->dig_P4 = int16_t(uint16_t(regs[13] << 8)|uint16_t(regs[12]));
+    calib->dig_P5 = int16_t(uint16_t(regs[15] << 8)|uint16_t(regs[14]));
+    calib->dig_P6 = int16_t(uint16_t(regs[17] << 8)|uint16_t(regs[16]));
+    calib->dig_P7 = int16_t(uint16_t(regs[19] << 8)|uint16_t(regs[18]));
+    calib->dig_P8 = int16_t(uint16_t(regs[21] << 8)|uint16_t(regs[20]));
+    calib->dig_P9 = int16_t(uint16_t(regs[23] << 8)|uint16_t(regs[22]));
+    calib->t_fine = 0;
+
+    calib->humidity = (hum_regs != 0);
+    if(!calib->humidity) return;
+    calib->dig_H1 = regs[25];
+    calib->dig_H2 = int16_t(uint16_t(hum_regs[1] << 8)|uint16_t(hum_regs[0]));
+    calib->dig_H3 = hum_regs[2];
+    calib->dig_H4 = int16_t((int8_t(hum_regs[3]) * 16)|(hum_regs[4] & 0x0F));
+    calib->dig_H5 = int16_t((int8_t(hum_regs[5]) * 16)|(hum_regs[4] >> 4));
+    calib->dig_H6 = int8_t(hum_regs[6]);
+}
+
+
+/**
+ * @brief Compensate temperature, updates t_fine
+ * @retval Temperature in 0.01 degC
+ */
+int32_t bmp280_compensateTemp(bmp280_calib* calib, int32_t temp_raw){
+    int32_t var1 = ((((temp_raw>>3) - ((int32_t)calib->dig_T1<<1))) * ((int32_t)calib->dig_T2)) >> 11;
+    int32_t var2 = (((((temp_raw>>4) - ((int32_t)calib->dig_T1)) * ((temp_raw>>4) - ((int32_t)calib->dig_T1))) >> 12) * ((int32_t)calib->dig_T3)) >> 14;
+    calib->t_fine = var1 + var2;
+    return (calib->t_fine*5 + 128) >> 8;
+}
+
+
+/**
+ * @brief Compensate pressure, uses t_fine of the last temperature
+ * @retval Pressure in Pa as Q24.8
+ */
+uint32_t bmp280_compensatePressure(const bmp280_calib* calib, int32_t pres_raw){
+    int64_t var1, var2, p;
+    var1 = ((int64_t)calib->t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t)calib->dig_P6;
+    var2 = var2 + ((var1*(int64_t)calib->dig_P5)<<17);
+    var2 = var2 + (((int64_t)calib->dig_P4)<<35);
+    var1 = ((var1 * var1 * (int64_t)calib->dig_P3)>>8) + ((var1 * (int64_t)calib->dig_P2)<<12);
+    var1 = (((((int64_t)1)<<47)+var1))*((int64_t)calib->dig_P1)>>33;
+
+    if (var1 == 0) return 0; // avoid exception caused by division by zero
+
+    p = 1048576-pres_raw;
+    p = (((p<<31)-var2)*3125)/var1;
+    var1 = (((int64_t)calib->dig_P9) * (p>>13) * (p>>13)) >> 25;
+    var2 = (((int64_t)calib->dig_P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)calib->dig_P7)<<4);
+
+    return (uint32_t)p;
+}
+
+
+/**
+ * @brief Compensate humidity, uses t_fine of the last temperature
+ * @retval Relative humidity in % as Q22.10
+ */
+uint32_t bmp280_compensateHumidity(const bmp280_calib* calib, int32_t hum_raw){
+    int32_t v_x1 = calib->t_fine - ((int32_t)76800);
+    v_x1 = (((((hum_raw << 14) - (((int32_t)calib->dig_H4) << 20) - (((int32_t)calib->dig_H5) * v_x1)) + ((int32_t)16384)) >> 15) *
+            (((((((v_x1 * ((int32_t)calib->dig_H6)) >> 10) * (((v_x1 * ((int32_t)calib->dig_H3)) >> 11) + ((int32_t)32768))) >> 10) +
+            ((int32_t)2097152)) * ((int32_t)calib->dig_H2) + 8192) >> 14));
+    v_x1 = v_x1 - (((((v_x1 >> 15) * (v_x1 >> 15)) >> 7) * ((int32_t)calib->dig_H1)) >> 4);
+    v_x1 = (v_x1 < 0) ? 0 : v_x1;
+    v_x1 = (v_x1 > 419430400) ? 419430400 : v_x1;
+    return (uint32_t)(v_x1 >> 12);
+}
+
+
+/**
+ * @brief Compensate raw frame with integer arithmetic only
+ * @param calib: sensor calibration.
+ * @param raw: uncompensated values.
+ * @param sample: compensated values (see bmp_sample), humidity is 0 for bmp280.
+ */
+void bmp280_compensate(bmp280_calib* calib, const bmp_raw* raw, bmp_sample* sample){
+    sample->temperature = bmp280_compensateTemp(calib, raw->temperature);
+    sample->pressure = bmp280_compensatePressure(calib, raw->pressure);
+    sample->humidity = calib->humidity ? bmp280_compensateHumidity(calib, raw->humidity) : 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file bmp280_compensate.h
+ * @author Denys Khmil
+ * @brief This file contents the hardware independent bmp280/BME280 calibration and compensation
+ */
+#ifndef BMP280_COMPENSATE
+#define BMP280_COMPENSATE
+
+#include <stdint.h>
+#include "bmp_sample.h"
+
+/*CALIBRATION*/
+#define BMP280_CALIB_ADDR       0x88
+#define BMP280_CALIB_LENGTH     24
+#define BME280_CALIB_LENGTH     26
+#define BME280_CALIB_H_ADDR     0xE1
+#define BME280_CALIB_H_LENGTH   7
+
+/**
+ * @brief bmp280 calibration constants, BME280 adds the humidity constants
+ * @note t_fine is updated by every temperature compensation
+ */
+struct bmp280_calib{
+    /*TEMPERATURE CALIBRATION CONSTANTS*/
+    uint16_t dig_T1;
+    int16_t dig_T2;
+    int16_t dig_T3;
+
+    /*PRESSURE CALIBRATION CONSTANTS*/
+    uint16_t dig_P1;
+    int16_t dig_P2;
+    int16_t dig_P3;
+    int16_t dig_P4;
+    int16_t dig_P5;
+    int16_t dig_P6;
+    int16_t dig_P7;
+    int16_t dig_P8;
+    int16_t dig_P9;
+
+    /*HUMIDITY CALIBRATION CONSTANTS (BME280)*/
+    uint8_t humidity;
+    uint8_t dig_H1;
+    int16_t dig_H2;
+    uint8_t dig_H3;
+    int16_t dig_H4;
+    int16_t dig_H5;
+    int8_t dig_H6;
+
+    int32_t t_fine;
+};
+
+/*CALIBRATION FUNCTIONS*/
+void bmp280_parseCalibration(const uint8_t* regs, const uint8_t* hum_regs, bmp280_calib* calib);
+
+/*CONVERT FUNCTIONS*/
+int32_t bmp280_compensateTemp(bmp280_calib* calib, int32_t temp_raw);
+uint32_t bmp280_compensatePressure(const bmp280_calib* calib, int32_t pres_raw);
+uint32_t bmp280_compensateHumidity(const bmp280_calib* calib, int32_t hum_raw);
+void bmp280_compensate(bmp280_calib* calib, const bmp_raw* raw, bmp_sample* sample);
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file bmp280_group.cpp
+ * @author Denys Khmil
+ * @brief This file contents the bmp280_group functions
+ */
+#include "bmp280_group.h"
+
+/**
+ * @brief Group of sensors sampled together in forced mode
+ * @param _sensors: initialized sensors (one bus, or several buses in any order).
+ * @param _count: number of sensors (up to BMP280_GROUP_MAX_SENSORS).
+ * @param _clock_us: free running microsecond clock (e.g. DWT cycle counter) to measure the
+ *        trigger skew, 0 uses the nominal ctrl_meas write time of the bus.
+ * @note Sensors 0 and 1 form the differential pair (pressure 0 - pressure 1)
+ */
+bmp280_group::bmp280_group(bmp280** _sensors, uint8_t _count, uint32_t (*_clock_us)()){
+    this->sensors = _sensors;
+    this->count = (_count > BMP280_GROUP_MAX_SENSORS) ? BMP280_GROUP_MAX_SENSORS : _count;
+    this->clockUs = _clock_us;
+    this->triggerTick = 0;
+    this->conversionTime = 0;
+    this->skew = 0;
+    this->skewMax = 0;
+    this->diff = 0;
+    this->offsetQ8 = 0;
+    this->zeroSum = 0;
+    this->zeroTarget = 0;
+    this->zeroCount = 0;
+    this->trackShift = 0;
+}
+
+
+/**
+ * @brief Start conversions of all sensors back-to-back
+ * @retval HAL_OK if every trigger write succeeded
+ * @note Only the ctrl_meas writes separate the conversion starts; the skew between the
+ *       first and the last start is recorded (lastSkew(), maxSkew())
+ */
+HAL_StatusTypeDef bmp280_group::trigger(){
+    HAL_StatusTypeDef result = HAL_OK;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    this->conversionTime = 0;
+    for(uint8_t i = 0; i < this->count; i++){
+        if(this->clockUs) last = this->clockUs();
+        if(!i) first = last;
+        if(this->sensors[i]->trigger() != HAL_OK) result = HAL_ERROR;
+        uint32_t time = this->sensors[i]->measurementTime();
+        if(time > this->conversionTime) this->conversionTime = time;
+    }
+    this->triggerTick = HAL_GetTick();
+
+    if(this->clockUs) this->skew = last - first;
+    else{
+        uint32_t write_bits = (1 + 3) * 9 + 3;
+        this->skew = (this->count - 1) * (write_bits * 1000000UL / this->sensors[0]->getBusClock());
+    }
+    if(this->skew > this->skewMax) this->skewMax = this->skew;
+    return result;
+}
+
+
+/**
+ * @brief Check if all conversions are done
+ * @note No bus access before the typical conversion time has passed
+ */
+uint8_t bmp280_group::ready(){
+    if((HAL_GetTick() - this->triggerTick) * 1000 < this->conversionTime) return 0;
+    for(uint8_t i = 0; i < this->count; i++){
+        if(this->sensors[i]->conversionRunning()) return 0;
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Read all sensors back-to-back and update the differential pressure
+ * @param samples: compensated values, one per sensor.
+ * @retval HAL_OK if every read succeeded (the differential is updated only then)
+ */
+HAL_StatusTypeDef bmp280_group::read(bmp_sample* samples){
+    HAL_StatusTypeDef result = HAL_OK;
+    for(uint8_t i = 0; i < this->count; i++){
+        if(this->sensors[i]->getSample(&samples[i]) != HAL_OK) result = HAL_ERROR;
+    }
+    if(result == HAL_OK && this->count >= 2) this->updateDifferential(samples);
+    return result;
+}
+
+
+/**
+ * @brief Trigger, wait for the conversions and read in one scheduled batch
+ * @param samples: compensated values, one per sensor.
+ * @retval HAL status, HAL_TIMEOUT if a conversion did not finish in time
+ */
+HAL_StatusTypeDef bmp280_group::acquire(bmp_sample* samples){
+    if(this->trigger() != HAL_OK) return HAL_ERROR;
+    HAL_Delay(this->conversionTime / 1000);
+    uint32_t limit = this->conversionTime / 1000 + BMP280_GROUP_READY_MARGIN;
+    while(!this->ready()){
+        if(HAL_GetTick() - this->triggerTick > limit) return HAL_TIMEOUT;
+    }
+    return this->read(samples);
+}
+
+
+/**
+ * @brief Estimate the pair offset from the next batches
+ * @param batches: number of batches averaged (0 cancels).
+ * @note The differential must be zero meanwhile (e.g. no airflow, ports at the same level)
+ */
+void bmp280_group::zero(uint16_t batches){
+    this->zeroSum = 0;
+    this->zeroCount = 0;
+    this->zeroTarget = batches;
+}
+
+
+/**
+ * @brief Track the offset continuously with an exponential average
+ * @param shift: time constant of 2^shift batches, 0 turns tracking off.
+ * @note Only for setups whose true differential averages to zero over that time
+ */
+void bmp280_group::setTracking(uint8_t shift){
+    this->trackShift = (shift > 16) ? 16 : shift;
+}
+
+
+/**
+ * @brief Set offset (e.g. restored from non-volatile memory)
+ * @param _offset: offset in Q24.8 Pa.
+ */
+void bmp280_group::setOffset(int32_t _offset){
+    this->offsetQ8 = _offset * 256;
+}
+
+
+/**
+ * @brief Check if zero() is still averaging
+ */
+uint8_t bmp280_group::zeroing(){
+    return this->zeroTarget != 0;
+}
+
+
+/**
+ * @brief Differential pressure of the last batch with the offset removed
+ * @retval Pressure 0 - pressure 1 in Q24.8 Pa
+ */
+int32_t bmp280_group::differential(){
+    return this->diff - this->offset();
+}
+
+
+/**
+ * @brief Estimated pair offset in Q24.8 Pa
+ */
+int32_t bmp280_group::offset(){
+    return (this->offsetQ8 >= 0) ? (this->offsetQ8 + 128) / 256 : (this->offsetQ8 - 128) / 256;
+}
+
+
+/**
+ * @brief Trigger skew of the last batch in us
+ */
+uint32_t bmp280_group::lastSkew(){
+    return this->skew;
+}
+
+
+/**
+ * @brief Largest trigger skew seen in us
+ */
+uint32_t bmp280_group::maxSkew(){
+    return this->skewMax;
+}
+
+
+/**
+ * @brief Update raw differential and offset estimate
+ * @note The offset keeps 8 extra fraction bits so slow tracking does not stall on rounding
+ */
+void bmp280_group::updateDifferential(const bmp_sample* samples){
+    this->diff = (int32_t)(samples[0].pressure - samples[1].pressure);
+    if(this->zeroTarget){
+        this->zeroSum += this->diff;
+        if(++this->zeroCount >= this->zeroTarget){
+            this->offsetQ8 = (int32_t)(this->zeroSum * 256 / this->zeroCount);
+            this->zeroTarget = 0;
+        }
+    }
+    else if(this->trackShift){
+        this->offsetQ8 += ((int32_t)this->diff * 256 - this->offsetQ8) >> this->trackShift;
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * @file bmp280_group.h
+ * @author Denys Khmil
+ * @brief This file contents the bmp280_group class (synchronized forced mode sampling)
+ */
+#ifndef BMP280_GROUP
+#define BMP280_GROUP
+
+#include "bmp280_lib.h"
+
+#define BMP280_GROUP_MAX_SENSORS    4
+#define BMP280_GROUP_READY_MARGIN   10
+
+class bmp280_group{
+public:
+    /*CONSTRUCTORS*/
+    bmp280_group(bmp280** _sensors, uint8_t _count, uint32_t (*_clock_us)() = 0);
+
+    /*ACQUISITION*/
+    HAL_StatusTypeDef trigger();
+    uint8_t ready();
+    HAL_StatusTypeDef read(bmp_sample* samples);
+    HAL_StatusTypeDef acquire(bmp_sample* samples);
+
+    /*DIFFERENTIAL PRESSURE*/
+    void zero(uint16_t batches);
+    void setTracking(uint8_t shift);
+    void setOffset(int32_t _offset);
+    uint8_t zeroing();
+    int32_t differential();
+    int32_t offset();
+
+    /*SKEW*/
+    uint32_t lastSkew();
+    uint32_t maxSkew();
+
+private:
+    void updateDifferential(const bmp_sample* samples);
+
+    /*SENSORS*/
+    bmp280** sensors;
+    uint8_t count;
+    uint32_t (*clockUs)();
+
+    /*TRIGGER STATE*/
+    uint32_t triggerTick;
+    uint32_t conversionTime;
+    uint32_t skew;
+    uint32_t skewMax;
+
+    /*OFFSET ESTIMATION*/
+    int32_t diff;
+    int32_t offsetQ8;
+    int64_t zeroSum;
+    uint16_t zeroTarget;
+    uint16_t zeroCount;
+    uint8_t trackShift;
+};
+
+#endif
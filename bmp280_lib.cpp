@@ -9,11 +9,24 @@
  * @brief bmp280 constructor with specified i2c address
  * @param _i2c: bmp280 i2c port.
  * @param _address bmp280 address.
- * @note Saves i2c port and adress, sets bmp280 to default mode (16bit temp, oversampling*4, normal mode)
+ * @note Saves i2c port and adress, sets bmp280 to default mode (16bit temp, oversampling*4, normal mode).
+ *       BME280 is detected by chip id and its humidity is measured with oversampling*1
  */
 bmp280::bmp280(I2C_HandleTypeDef _i2c, uint8_t _address){
     this->i2c = _i2c;
     this->address = _address;
+    this->busClock = BMP280_I2C_SM_CLOCK;
+    this->hsEnter = 0;
+    this->status = HAL_OK;
+    this->asyncBus = 0;
+    this->chipId = 0;
+    this->calib.t_fine = 0;
+    this->calib.humidity = 0;
+    this->ctrlMeas = 0;
+    this->configReg = 0;
+    this->ctrlHum = 0;
+    this->read_id();
+    this->setHumidity(0b001);
     this->settings(0b001, 0b011, 0b11);
     this->setConfig(0);
     this->readCalibration();
@@ -23,17 +36,137 @@ bmp280::bmp280(I2C_HandleTypeDef _i2c, uint8_t _address){
 /**
  * @brief bmp280 constructor with defauld i2c address
  * @param _i2c: bmp280 i2c port.
- * @note Saves i2c port and adress, sets bmp280 to default mode (16bit temp, oversampling*4, normal mode)
+ * @note Saves i2c port and adress, sets bmp280 to default mode (16bit temp, oversampling*4, normal mode).
+ *       BME280 is detected by chip id and its humidity is measured with oversampling*1
  */
 bmp280::bmp280(I2C_HandleTypeDef _i2c){
     this->i2c = _i2c;
     this->address = 0b1110110;
+    this->busClock = BMP280_I2C_SM_CLOCK;
+    this->hsEnter = 0;
+    this->status = HAL_OK;
+    this->asyncBus = 0;
+    this->chipId = 0;
+    this->calib.t_fine = 0;
+    this->calib.humidity = 0;
+    this->ctrlMeas = 0;
+    this->configReg = 0;
+    this->ctrlHum = 0;
+    this->read_id();
+    this->setHumidity(0b001);
     this->settings(0b010, 0b011, 0b11);
     this->setConfig(0);
     this->readCalibration();
 }
 
 
+/**
+ * @brief bmp280 constructor without i2c transfers
+ * @note Sensor must be initialized with init() or discover() before use
+ */
+bmp280::bmp280(){
+    this->address = BMP280_ADDRESS_PRIMARY;
+    this->busClock = BMP280_I2C_SM_CLOCK;
+    this->hsEnter = 0;
+    this->status = HAL_OK;
+    this->asyncBus = 0;
+    this->chipId = 0;
+    this->calib.t_fine = 0;
+    this->calib.humidity = 0;
+    this->ctrlMeas = 0;
+    this->configReg = 0;
+    this->ctrlHum = 0;
+}
+
+
+/**
+ * @brief Initialize sensor on specified i2c port and address
+ * @param _i2c: bmp280 i2c port.
+ * @param _address bmp280 address.
+ * @note Same default mode as the constructors, calibration is loaded
+ */
+void bmp280::init(I2C_HandleTypeDef _i2c, uint8_t _address){
+    this->i2c = _i2c;
+    this->address = _address;
+    this->chipId = 0;
+    this->read_id();
+    this->setHumidity(0b001);
+    this->settings(0b010, 0b011, 0b11);
+    this->setConfig(0);
+    this->readCalibration();
+}
+
+
+/**
+ * @brief Probe 0x76/0x77 on all buses and initialize found sensors
+ * @param buses: i2c handles used by the application (interrupt mode must be enabled).
+ * @param bus_count: number of buses (up to BMP280_DISCOVERY_MAX_BUSES).
+ * @param sensors: storage for found sensors.
+ * @param max_sensors: size of sensors storage.
+ * @param probe_timeout: chip id read timeout in ms.
+ * @retval Number of initialized sensors
+ * @note Chip id reads are started on every bus at once, so one address costs a single
+ *       probe_timeout for all buses. Timed out reads are aborted and waited for up to another
+ *       probe_timeout, a bus still busy after that is not probed again.
+ *       Sensors keep the bus clock settings of their storage.
+ */
+uint8_t bmp280::discover(I2C_HandleTypeDef** buses, uint8_t bus_count, bmp280* sensors, uint8_t max_sensors, uint32_t probe_timeout){
+    static const uint8_t addresses[2] = {BMP280_ADDRESS_PRIMARY, BMP280_ADDRESS_SECONDARY};
+    uint8_t id[BMP280_DISCOVERY_MAX_BUSES];
+    uint8_t pending[BMP280_DISCOVERY_MAX_BUSES];
+    uint8_t dead[BMP280_DISCOVERY_MAX_BUSES];
+    uint8_t found = 0;
+    if(bus_count > BMP280_DISCOVERY_MAX_BUSES) bus_count = BMP280_DISCOVERY_MAX_BUSES;
+    for(uint8_t b = 0; b < bus_count; b++) dead[b] = 0;
+
+    for(uint8_t a = 0; a < 2; a++){
+        uint8_t running = 0;
+        for(uint8_t b = 0; b < bus_count; b++){
+            id[b] = 0;
+            pending[b] = !dead[b] && (HAL_I2C_Mem_Read_IT(buses[b], (uint16_t)(addresses[a] << 1), 0xD0, I2C_MEMADD_SIZE_8BIT, &id[b], 1) == HAL_OK);
+            running += pending[b];
+        }
+
+        uint32_t start = HAL_GetTick();
+        while(running && (HAL_GetTick() - start) <= probe_timeout){
+            for(uint8_t b = 0; b < bus_count; b++){
+                if(pending[b] && HAL_I2C_GetState(buses[b]) == HAL_I2C_STATE_READY){
+                    pending[b] = 0;
+                    running--;
+                }
+            }
+        }
+
+        /*the abort completes in the interrupt, a bus that does not get ready is skipped from now on*/
+        running = 0;
+        for(uint8_t b = 0; b < bus_count; b++){
+            if(!pending[b]) continue;
+            if(HAL_I2C_Master_Abort_IT(buses[b], (uint16_t)(addresses[a] << 1)) == HAL_OK) running++;
+            else dead[b] = 1;
+        }
+        start = HAL_GetTick();
+        while(running && (HAL_GetTick() - start) <= probe_timeout){
+            running = 0;
+            for(uint8_t b = 0; b < bus_count; b++){
+                if(pending[b] && !dead[b] && HAL_I2C_GetState(buses[b]) != HAL_I2C_STATE_READY) running++;
+            }
+        }
+
+        for(uint8_t b = 0; b < bus_count; b++){
+            if(pending[b]){
+                if(HAL_I2C_GetState(buses[b]) != HAL_I2C_STATE_READY) dead[b] = 1;
+                continue;
+            }
+            if(isChipId(id[b]) && found < max_sensors){
+                sensors[found].init(*buses[b], addresses[a]);
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+
 /**
  * @brief Changes sensor settings
  * @param osrs_p: Pressure measurement settings register.
@@ -41,16 +174,54 @@ bmp280::bmp280(I2C_HandleTypeDef _i2c){
  * @param mode: Sensor mode.
  */
 void bmp280::settings(uint8_t osrs_p, uint8_t osrs_t, uint8_t mode){    
-    uint8_t reg = (osrs_t << 5)|(osrs_p << 2)|(mode);
-    HAL_I2C_Mem_Write(&this->i2c, (this->address << 1), 0xf4, I2C_MEMADD_SIZE_8BIT, &reg, 1, 1000);
+    this->ctrlMeas = (osrs_t << 5)|(osrs_p << 2)|(mode);
+    this->writeRegister(0xf4, this->ctrlMeas);
 }
 
 
 /**
  * @brief Set sensor configuration
+ * @param t_sb: Standby time in normal mode (0b000 = 0.5 ms .. 0b111 = 4000 ms, on BME280 0b110 = 10 ms and 0b111 = 20 ms).
+ * @param filter: IIR filter coefficient (0b000 = off, 0b001 = 2, 0b010 = 4, 0b011 = 8, 0b100 = 16).
+ */
+void bmp280::setConfig(uint8_t t_sb, uint8_t filter){
+    this->configReg = ((t_sb & 0x07) << 5)|((filter & 0x07) << 2);
+    this->writeRegister(0xf5, this->configReg);
+}
+
+
+/**
+ * @brief Set humidity oversampling (BME280 only)
+ * @param osrs_h: Humidity measurement settings register.
+ * @note ctrl_hum takes effect on the next ctrl_meas write, so ctrl_meas is rewritten
+ */
+void bmp280::setHumidity(uint8_t osrs_h){
+    if(!this->hasHumidity()) return;
+    this->ctrlHum = osrs_h & 0x07;
+    this->writeRegister(0xf2, this->ctrlHum);
+    this->writeRegister(0xf4, this->ctrlMeas);
+}
+
+
+/**
+ * @brief Start one forced mode conversion with the current oversampling
+ * @retval HAL status of the ctrl_meas write
+ * @note Conversion starts at the end of the write and takes measurementTime()
+ */
+HAL_StatusTypeDef bmp280::trigger(){
+    this->ctrlMeas = (this->ctrlMeas & 0xFC)|BMP280_MODE_FORCED;
+    return this->writeRegister(0xf4, this->ctrlMeas);
+}
+
+
+/**
+ * @brief Typical conversion time of the current oversampling
+ * @retval Time in us (humidity included for BME280)
  */
-void bmp280::setConfig(uint8_t t_sb){
-    HAL_I2C_Mem_Write(&this->i2c, (this->address << 1), 0xf5, I2C_MEMADD_SIZE_8BIT, &t_sb, 1, 1000);
+uint32_t bmp280::measurementTime(){
+    uint32_t time = bmp280_measurementTime((this->ctrlMeas >> 2) & 0x07, this->ctrlMeas >> 5);
+    if(this->hasHumidity() && this->ctrlHum) time += 2000 * (uint32_t)bmp280_oversampling(this->ctrlHum) + 500;
+    return time;
 }
 
 
@@ -58,8 +229,7 @@ void bmp280::setConfig(uint8_t t_sb){
  * @brief Software reset for sensor
  */
 void bmp280::Reset(){
-    uint8_t value = 0xb6;
-    HAL_I2C_Mem_Write(&this->i2c, (this->address << 1), 0xe0, I2C_MEMADD_SIZE_8BIT, &value, 1, 1000);
+    this->writeRegister(0xe0, 0xb6);
 }
 
 
@@ -68,7 +238,7 @@ void bmp280::Reset(){
  */
 uint8_t bmp280::conversionRunning(){
     uint8_t reg;
-    HAL_I2C_Mem_Read(&this->i2c, (this->address << 1), 0xf3, I2C_MEMADD_SIZE_8BIT, &reg, 1, 1000);
+    this->readRegisters(0xf3, &reg, 1);
     return reg & 0x08;
 }
 
@@ -78,62 +248,160 @@ uint8_t bmp280::conversionRunning(){
  */
 uint8_t bmp280::dataCopying(){
     uint8_t reg;
-    HAL_I2C_Mem_Read(&this->i2c, (this->address << 1), 0xf3, I2C_MEMADD_SIZE_8BIT, &reg, 1, 1000);
+    this->readRegisters(0xf3, &reg, 1);
     return reg & 0x08;
 }
 
 
 /**
- * @brief Read sensor id (default 0x58)
+ * @brief Read sensor id (default 0x58, 0x60 for BME280)
  * @retval id uint8_t
+ * @note Read id selects the humidity path for BME280
  */
 uint8_t bmp280::read_id(){
-    uint8_t id;
-    HAL_I2C_Mem_Read(&this->i2c, (uint16_t)(this->address << 1), 0xD0, I2C_MEMADD_SIZE_8BIT, &id, 1, 1000);
+    uint8_t id = 0;
+    if(this->readRegisters(0xD0, &id, 1) == HAL_OK){
+        this->chipId = id;
+    }
     return id;
 }
 
 
 /**
- * @brief Read calibration constants from sensor
+ * @brief Check if id belongs to bmp280
+ * @param id: value of id register.
+ * @retval 1 for bmp280 samples (0x56, 0x57), mass production (0x58) and BME280 (0x60), 0 otherwise
  */
-void bmp280::readCalibration(){
-    this->dig_T1 = this->readU16bit(0x88);
-    this->dig_T2 = this->readS16bit(0x8a);
-    this->dig_T3 = this->readS16bit(0x8c);
-    this->dig_P1 = this->readU16bit(0x8e);
-    this->dig_P2 = this->readS16bit(0x90);
-    this->dig_P3 = this->readS16bit(0x92);
-    this->dig_P4 = this->readS16bit(0x94);
-    this->dig_P5 = this->readS16bit(0x96);
-    this->dig_P6 = this->readS16bit(0x98);
-    this->dig_P7 = this->readS16bit(0x9a);
-    this->dig_P8 = this->readS16bit(0x9c);
-    this->dig_P9 = this->readS16bit(0x9e);
+uint8_t bmp280::isChipId(uint8_t id){
+    return (id == 0x56) || (id == 0x57) || (id == BMP280_CHIP_ID) || (id == BME280_CHIP_ID);
+}
+
+
+/**
+ * @brief Check if sensor has humidity channel
+ * @retval 1 for BME280
+ */
+uint8_t bmp280::hasHumidity(){
+    return this->chipId == BME280_CHIP_ID;
+}
+
+
+/**
+ * @brief Restore settings and calibration after sensor power loss
+ * @note Rewrites the last settings()/setConfig() values and reloads calibration
+ */
+void bmp280::restore(){
+    if(this->hasHumidity()) this->writeRegister(0xf2, this->ctrlHum);
+    this->writeRegister(0xf5, this->configReg);
+    this->writeRegister(0xf4, this->ctrlMeas);
+    this->readCalibration();
+}
+
+
+/**
+ * @brief Get calibration constants of the sensor
+ * @retval Calibration for host side compensation of raw frames
+ */
+const bmp280_calib& bmp280::getCalibration(){
+    return this->calib;
+}
+
+
+/**
+ * @brief Get status of the last i2c transfer
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp280::getStatus(){
+    return this->status;
+}
+
+
+/**
+ * @brief Set i2c bus clock used for timeouts and HS-mode handshake
+ * @param clock: bus clock in Hz (100000, 400000, 1000000 or 3400000), 0 is ignored.
+ * @param hs_hook: transport hook called before every transfer in HS-mode.
+ * @note Above 1 MHz the bus runs in HS-mode: the hook must send the master code (0b00001xxx)
+ *       at Fm speed and switch the peripheral to HS timing before returning.
+ */
+void bmp280::setBusClock(uint32_t clock, void (*hs_hook)(I2C_HandleTypeDef* hi2c)){
+    if(!clock) return;
+    this->busClock = clock;
+    this->hsEnter = (clock > BMP280_I2C_FMP_CLOCK) ? hs_hook : 0;
+}
+
+
+/**
+ * @brief Bus clock used for timeouts and timing estimates
+ */
+uint32_t bmp280::getBusClock(){
+    return this->busClock;
+}
+
+
+/**
+ * @brief Estimate bus limited sample rate of readRaw() transfers
+ * @param clock: bus clock in Hz.
+ * @param humidity: 1 for the 8 byte BME280 burst (see hasHumidity()).
+ * @retval Samples per second one bus can carry, 0 for clock 0
+ * @note Timing model: start, address+W, register, repeated start, address+R, 6 (8) data bytes, stop.
+ *       In HS-mode the master code is sent at Fm speed before every transfer.
+ */
+uint32_t bmp280::maxSampleRate(uint32_t clock, uint8_t humidity){
+    if(!clock) return 0;
+    uint32_t bits = humidity ? BME280_I2C_READRAW_BITS : BMP280_I2C_READRAW_BITS;
+    uint32_t transfer_ns = (bits * 1000000000ULL) / clock;
+    if(clock > BMP280_I2C_FMP_CLOCK){
+        transfer_ns += (BMP280_I2C_MASTER_CODE_BITS * 1000000000ULL) / BMP280_I2C_FM_CLOCK;
+    }
+    return 1000000000UL / transfer_ns;
+}
+
+
+/**
+ * @brief Bus limited sample rate of this sensor at its bus clock
+ */
+uint32_t bmp280::maxSampleRate(){
+    return maxSampleRate(this->busClock, this->hasHumidity());
+}
+
+
+/**
+ * @brief Estimate sensor current and energy per sample of the active configuration
+ * @param polls: status reads per sample (conversionRunning() loops).
+ * @param forced_period_us: sample period in forced mode (ignored in normal mode).
+ * @param energy: estimate from ctrl_meas/config/ctrl_hum and the bus clock.
+ * @note Bus energy assumes BMP280_BUS_VDD_MV and BMP280_BUS_CURRENT_UA
+ */
+void bmp280::estimateEnergy(uint8_t polls, uint32_t forced_period_us, bmp280_energy* energy){
+    bmp280_bus_model bus = {this->busClock, BMP280_BUS_VDD_MV, BMP280_BUS_CURRENT_UA};
+    bmp280_estimateEnergy(this->ctrlMeas, this->configReg, this->hasHumidity() ? this->ctrlHum : 0, &bus, polls, forced_period_us, energy, this->hasHumidity());
 }
 
 
 /**
- * @brief Read unsigned 16bit
- * @retval uint16_t
+ * @brief Check active configuration against a sensor current budget
+ * @param max_na: largest allowed average sensor current in nA.
+ * @retval 1 if the estimate is within budget
  */
-uint16_t bmp280::readU16bit(uint8_t addr){
-    uint16_t data = 0;
-    uint8_t buffer[2];
-    HAL_I2C_Master_Transmit(&this->i2c,(this->address << 1), &addr, 1, 100);
-    HAL_I2C_Master_Receive(&this->i2c,(this->address << 1), buffer, 2, 100);
-    data = uint16_t(buffer[1] << 8)|uint16_t(buffer[0]);
-    return data;
+uint8_t bmp280::withinBudget(uint32_t max_na, uint8_t polls, uint32_t forced_period_us){
+    bmp280_energy energy;
+    this->estimateEnergy(polls, forced_period_us, &energy);
+    return energy.sensor_na <= max_na;
 }
 
 
 /**
- * @brief Read signed 16bit
- * @retval int16_t
+ * @brief Read calibration constants from sensor
+ * @note All constants are read in one 24 byte burst (0x88..0x9F),
+ *       BME280 extends it to 0xA1 and reads humidity constants from 0xE1..0xE7
  */
-int16_t bmp280::readS16bit(uint8_t addr){
-    uint16_t data = this->readU16bit(addr);
-    return int16_t(data);
+void bmp280::readCalibration(){
+    uint8_t buffer[BME280_CALIB_LENGTH];
+    uint8_t hum_buffer[BME280_CALIB_H_LENGTH];
+    uint8_t humidity = this->hasHumidity();
+    this->readRegisters(BMP280_CALIB_ADDR, buffer, humidity ? BME280_CALIB_LENGTH : BMP280_CALIB_LENGTH);
+    if(humidity) this->readRegisters(BME280_CALIB_H_ADDR, hum_buffer, BME280_CALIB_H_LENGTH);
+    bmp280_parseCalibration(buffer, humidity ? hum_buffer : 0, &this->calib);
 }
 
 
@@ -141,21 +409,115 @@ int16_t bmp280::readS16bit(uint8_t addr){
  * @brief Get temperature and pressure from sensor
  */
 void bmp280::getTempPressure(double* temperature, double* pressure){
-    int32_t temperature_raw, pressure_raw;
-    this->readAll(&temperature_raw, &pressure_raw);
-    *temperature = this->convertTemp(temperature_raw);
-    *pressure = this->convertPressure(pressure_raw);
+    bmp_raw raw;
+    this->readRaw(&raw);
+    *temperature = this->convertTemp(raw.temperature);
+    *pressure = this->convertPressure(raw.pressure);
+}
+
+
+/**
+ * @brief Get temperature, pressure and humidity from sensor
+ * @note Humidity is 0 for bmp280
+ */
+void bmp280::getTempPressureHumidity(double* temperature, double* pressure, double* humidity){
+    bmp_raw raw;
+    this->readRaw(&raw);
+    *temperature = this->convertTemp(raw.temperature);
+    *pressure = this->convertPressure(raw.pressure);
+    *humidity = this->hasHumidity() ? this->convertHumidity(raw.humidity) : 0.0;
+}
+
+
+/**
+ * @brief Read all the data registers in one burst
+ * @param raw: uncompensated values.
+ * @retval HAL status
+ * @note bmp280 reads 0xF7..0xFC, BME280 reads 0xF7..0xFE including humidity
+ */
+HAL_StatusTypeDef bmp280::readRaw(bmp_raw* raw){
+    uint8_t buffer[8];
+    uint8_t humidity = this->hasHumidity();
+    HAL_StatusTypeDef result = this->readRegisters(0xF7, buffer, humidity ? 8 : 6);
+    parseRaw(buffer, humidity, raw);
+    return result;
+}
+
+
+/**
+ * @brief Compensate raw values with integer arithmetic only
+ * @param raw: uncompensated values.
+ * @param sample: compensated values (see bmp_sample).
+ */
+void bmp280::compensate(const bmp_raw* raw, bmp_sample* sample){
+    bmp280_compensate(&this->calib, raw, sample);
+}
+
+
+/**
+ * @brief Get fixed-point sample from sensor
+ * @param sample: compensated values (see bmp_sample).
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp280::getSample(bmp_sample* sample){
+    bmp_raw raw;
+    HAL_StatusTypeDef result = this->readRaw(&raw);
+    this->compensate(&raw, sample);
+    return result;
+}
+
+
+/**
+ * @brief Set the handle used for interrupt driven reads
+ * @param hi2c: the application's i2c handle (the one its HAL callbacks receive).
+ * @note The sensor keeps a copy of its handle for blocking transfers, interrupt
+ *       transfers must run on the handle the interrupt handlers update
+ */
+void bmp280::setAsyncBus(I2C_HandleTypeDef* hi2c){
+    this->asyncBus = hi2c;
+}
+
+
+/**
+ * @brief Check if a HAL callback belongs to this sensor's interrupt driven reads
+ */
+uint8_t bmp280::ownsBus(I2C_HandleTypeDef* hi2c){
+    return this->asyncBus && this->asyncBus == hi2c;
 }
 
 
 /**
- * @brief Read all the data registers
+ * @brief Start burst read of the data registers in interrupt mode
+ * @retval HAL status of the start (HAL_ERROR without setAsyncBus())
+ * @note Completion is reported by HAL_I2C_MemRxCpltCallback/HAL_I2C_ErrorCallback,
+ *       then finishRead() parses the frame
  */
-void bmp280::readAll(int32_t *temperature_raw, int32_t *pressure_raw){
-    uint8_t buffer[6];
-    HAL_I2C_Mem_Read(&this->i2c, (uint16_t)(this->address << 1), 0xF7, I2C_MEMADD_SIZE_8BIT, buffer, 6, 1000);
-    *temperature_raw = (buffer[3] << 12)|(buffer[4] << 4)|(buffer[5] >> 4);
-    *pressure_raw = (buffer[0] << 12)|(buffer[1] << 4)|(buffer[2] >> 4);
+HAL_StatusTypeDef bmp280::startRead(){
+    if(!this->asyncBus){
+        this->status = HAL_ERROR;
+        return this->status;
+    }
+    if(this->hsEnter) this->hsEnter(this->asyncBus);
+    this->status = HAL_I2C_Mem_Read_IT(this->asyncBus, (uint16_t)(this->address << 1), 0xF7, I2C_MEMADD_SIZE_8BIT,
+                                       this->rxBuffer, this->hasHumidity() ? 8 : 6);
+    return this->status;
+}
+
+
+/**
+ * @brief Parse frame of a completed interrupt driven read
+ * @param raw: uncompensated values.
+ */
+void bmp280::finishRead(bmp_raw* raw){
+    parseRaw(this->rxBuffer, this->hasHumidity(), raw);
+}
+
+
+/**
+ * @brief Abort interrupt driven read (e.g. on timeout)
+ */
+void bmp280::abortRead(){
+    if(this->asyncBus) HAL_I2C_Master_Abort_IT(this->asyncBus, (uint16_t)(this->address << 1));
 }
 
 
@@ -176,7 +538,7 @@ double bmp280::getTemperature(){
 int32_t bmp280::readTemp(){
     int32_t temperature_raw = 0;
     uint8_t buffer[3];
-    HAL_I2C_Mem_Read(&this->i2c, (uint16_t)(this->address << 1), 0xFA, I2C_MEMADD_SIZE_8BIT, buffer, 3, 1000);
+    this->readRegisters(0xFA, buffer, 3);
     temperature_raw = (buffer[0] << 12)|(buffer[1] << 4)|(buffer[2] >> 4);
     return temperature_raw;
 }
@@ -185,12 +547,7 @@ int32_t bmp280::readTemp(){
  * @brief Convert values from sensor to celsius
  */
 double bmp280::convertTemp(int32_t temp_raw){
-    int32_t var1 = ((((temp_raw>>3) - ((int32_t)dig_T1<<1))) * ((int32_t)dig_T2)) >> 11;
-    int32_t var2 = (((((temp_raw>>4) - ((int32_t)dig_T1)) * ((temp_raw>>4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
-    t_fine = var1 + var2;
-    int32_t temperature = (t_fine*5 + 128) >> 8;
-
-    return temperature/100.0;
+    return bmp280_compensateTemp(&this->calib, temp_raw)/BMP_TEMPERATURE_SCALE;
 }
 
 
@@ -211,7 +568,7 @@ double bmp280::getPressure(){
 int32_t bmp280::readPressure(){
     int32_t pressure_raw;
     uint8_t buffer[3];
-    HAL_I2C_Mem_Read(&this->i2c, (uint16_t)(this->address << 1), 0xF7, 1, buffer, 3, 1000);
+    this->readRegisters(0xF7, buffer, 3);
     pressure_raw = (int32_t)((buffer[0] << 12)|(buffer[1] << 4)|(buffer[2] >> 4));
     return pressure_raw;
 }
@@ -221,21 +578,76 @@ int32_t bmp280::readPressure(){
  * @brief Convert pressure values from sensor to Pa
  */
 double bmp280::convertPressure(int32_t pres_raw){
-    int64_t var1, var2, p;
-    var1 = ((int64_t)t_fine) - 128000;
-    var2 = var1 * var1 * (int64_t)dig_P6;
-    var2 = var2 + ((var1*(int64_t)dig_P5)<<17);
-    var2 = var2 + (((int64_t)dig_P4)<<35);
-    var1 = ((var1 * var1 * (int64_t)dig_P3)>>8) + ((var1 * (int64_t)dig_P2)<<12);
-    var1 = (((((int64_t)1)<<47)+var1))*((int64_t)dig_P1)>>33;
-
-    if (var1 == 0) return 0.0; // avoid exception caused by division by zero
-
-    p = 1048576-pres_raw;
-    p = (((p<<31)-var2)*3125)/var1;
-    var1 = (((int64_t)dig_P9) * (p>>13) * (p>>13)) >> 25;
-    var2 = (((int64_t)dig_P8) * p) >> 19;
-    p = ((p + var1 + var2) >> 8) + (((int64_t)dig_P7)<<4);
-
-    return p/256.0;
+    return bmp280_compensatePressure(&this->calib, pres_raw)/BMP_PRESSURE_SCALE;
+}
+
+
+/**
+ * @brief Get humidity from sensor (BME280 only)
+ * @retval Relative humidity in % (double), 0 for bmp280
+ * @note Temperature is read in the same burst for t_fine
+ */
+double bmp280::getHumidity(){
+    double temperature, pressure, humidity;
+    this->getTempPressureHumidity(&temperature, &pressure, &humidity);
+    return humidity;
+}
+
+
+/**
+ * @brief Convert humidity values from sensor to %RH
+ */
+double bmp280::convertHumidity(int32_t hum_raw){
+    return bmp280_compensateHumidity(&this->calib, hum_raw)/BMP_HUMIDITY_SCALE;
+}
+
+
+/**
+ * @brief Unpack data registers 0xF7.. into raw values
+ * @param humidity: buffer holds the BME280 humidity bytes.
+ */
+void bmp280::parseRaw(const uint8_t* buffer, uint8_t humidity, bmp_raw* raw){
+    raw->temperature = (buffer[3] << 12)|(buffer[4] << 4)|(buffer[5] >> 4);
+    raw->pressure = (buffer[0] << 12)|(buffer[1] << 4)|(buffer[2] >> 4);
+    raw->humidity = humidity ? ((buffer[6] << 8)|buffer[7]) : 0;
+}
+
+
+/**
+ * @brief Read sensor registers
+ * @param reg: first register address.
+ * @param buffer: destination buffer.
+ * @param length: number of bytes to read.
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp280::readRegisters(uint8_t reg, uint8_t* buffer, uint16_t length){
+    if(this->hsEnter) this->hsEnter(&this->i2c);
+    this->status = HAL_I2C_Mem_Read(&this->i2c, (uint16_t)(this->address << 1), reg, I2C_MEMADD_SIZE_8BIT, buffer, length, this->timeout(length));
+    return this->status;
+}
+
+
+/**
+ * @brief Write sensor register
+ * @param reg: register address.
+ * @param value: register value.
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp280::writeRegister(uint8_t reg, uint8_t value){
+    if(this->hsEnter) this->hsEnter(&this->i2c);
+    this->status = HAL_I2C_Mem_Write(&this->i2c, (uint16_t)(this->address << 1), reg, I2C_MEMADD_SIZE_8BIT, &value, 1, this->timeout(1));
+    return this->status;
+}
+
+
+/**
+ * @brief Transfer timeout scaled to the bus clock
+ * @param length: number of data bytes.
+ * @retval Timeout in ms
+ * @note Twice the nominal transfer time (9 bits per byte plus address, register and restart),
+ *       plus one tick of margin for the HAL millisecond timer.
+ */
+uint32_t bmp280::timeout(uint16_t length){
+    uint32_t bits = (uint32_t)(length + 3) * 9 + BMP280_I2C_MASTER_CODE_BITS;
+    return (2 * bits * 1000) / this->busClock + 2;
 }
\ No newline at end of file
@@ -7,61 +7,120 @@
 #define BMP280_LIB
 
 #include "main.h"
+#include "bmp_sample.h"
+#include "bmp_sensor.h"
+#include "bmp280_compensate.h"
+#include "bmp280_model.h"
 #include <math.h>
 
+/*I2C BUS TIMING*/
+#define BMP280_I2C_SM_CLOCK         100000UL
+#define BMP280_I2C_FM_CLOCK         400000UL
+#define BMP280_I2C_FMP_CLOCK        1000000UL
+#define BMP280_I2C_READRAW_BITS     84
+#define BME280_I2C_READRAW_BITS     102
+#define BMP280_I2C_MASTER_CODE_BITS 10
+
+/*DISCOVERY*/
+#define BMP280_ADDRESS_PRIMARY      0x76
+#define BMP280_ADDRESS_SECONDARY    0x77
+#define BMP280_PROBE_TIMEOUT        2
+#define BMP280_DISCOVERY_MAX_BUSES  16
+
+/*CHIP IDS*/
+#define BMP280_CHIP_ID              0x58
+#define BME280_CHIP_ID              0x60
+
 class bmp280{
 public:
     /*CONSTRUCTORS*/
     bmp280(I2C_HandleTypeDef _i2c, uint8_t _address);
     bmp280(I2C_HandleTypeDef _i2c);
+    bmp280();
+    void init(I2C_HandleTypeDef _i2c, uint8_t _address);
+    static uint8_t discover(I2C_HandleTypeDef** buses, uint8_t bus_count, bmp280* sensors, uint8_t max_sensors, uint32_t probe_timeout = BMP280_PROBE_TIMEOUT);
     
     /*UTILITY FUNCTIONS*/
     void settings(uint8_t osrs_p, uint8_t osrs_t, uint8_t mode);
-    void setConfig(uint8_t t_sb);
+    void setConfig(uint8_t t_sb, uint8_t filter = 0);
+    void setHumidity(uint8_t osrs_h);
+    HAL_StatusTypeDef trigger();
+    uint32_t measurementTime();
     uint8_t conversionRunning();
     uint8_t dataCopying();
     void Reset();
     uint8_t read_id(); 
+    static uint8_t isChipId(uint8_t id);
+    uint8_t hasHumidity();
+    void restore();
+    HAL_StatusTypeDef getStatus();
+    const bmp280_calib& getCalibration();
+    void setBusClock(uint32_t clock, void (*hs_hook)(I2C_HandleTypeDef* hi2c) = 0);
+    uint32_t getBusClock();
+    static uint32_t maxSampleRate(uint32_t clock, uint8_t humidity = 0);
+    uint32_t maxSampleRate();
+
+    /*ENERGY FUNCTIONS*/
+    void estimateEnergy(uint8_t polls, uint32_t forced_period_us, bmp280_energy* energy);
+    uint8_t withinBudget(uint32_t max_na, uint8_t polls, uint32_t forced_period_us);
 
     /*MEASURINGS*/
     void getTempPressure(double* temperature, double* pressure);
+    void getTempPressureHumidity(double* temperature, double* pressure, double* humidity);
     double getTemperature();
     double getPressure();
+    double getHumidity();
+
+    /*FIXED-POINT MEASURINGS*/
+    HAL_StatusTypeDef readRaw(bmp_raw* raw);
+    void compensate(const bmp_raw* raw, bmp_sample* sample);
+    HAL_StatusTypeDef getSample(bmp_sample* sample);
+
+    /*INTERRUPT DRIVEN MEASURINGS*/
+    void setAsyncBus(I2C_HandleTypeDef* hi2c);
+    uint8_t ownsBus(I2C_HandleTypeDef* hi2c);
+    HAL_StatusTypeDef startRead();
+    void finishRead(bmp_raw* raw);
+    void abortRead();
 
 private:
     /*READ FUNCTIONS*/
-    void readAll(int32_t *temperature_raw, int32_t *pressure_raw);
     int32_t readTemp();
     int32_t readPressure();
-    uint16_t readU16bit(uint8_t addr);
-    int16_t readS16bit(uint8_t addr);
     void readCalibration();
+    static void parseRaw(const uint8_t* buffer, uint8_t humidity, bmp_raw* raw);
+
+    /*TRANSPORT FUNCTIONS*/
+    HAL_StatusTypeDef readRegisters(uint8_t reg, uint8_t* buffer, uint16_t length);
+    HAL_StatusTypeDef writeRegister(uint8_t reg, uint8_t value);
+    uint32_t timeout(uint16_t length);
     
     /*CONVERT FUNCTIONS*/
     double convertPressure(int32_t pres_raw);
     double convertTemp(int32_t temp_raw);
+    double convertHumidity(int32_t hum_raw);
     
     /*SENSOR PARAMETERS*/
     I2C_HandleTypeDef i2c;
     uint8_t address;
+    uint8_t chipId;
+    uint32_t busClock;
+    void (*hsEnter)(I2C_HandleTypeDef* hi2c);
+    HAL_StatusTypeDef status;
+    I2C_HandleTypeDef* asyncBus;
+    uint8_t rxBuffer[8];
 
-    /*TEMPERATURE CALIBRATION CONSTANTS*/
-    uint16_t dig_T1;
-    int16_t dig_T2;
-    int16_t dig_T3;
+    /*REGISTER SHADOWS*/
+    uint8_t ctrlMeas;
+    uint8_t configReg;
+    uint8_t ctrlHum;
 
-    /*PRESSURE CALIBRATION CONSTANTS*/
-    uint16_t dig_P1;
-    int16_t dig_P2;
-    int16_t dig_P3;
-    int16_t dig_P4;
-    int16_t dig_P5;
-    int16_t dig_P6;
-    int16_t dig_P7;
-    int16_t dig_P8;
-    int16_t dig_P9;
-
-    int32_t t_fine;
+    /*CALIBRATION CONSTANTS*/
+    bmp280_calib calib;
 };
 
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+static_assert(bmp_sensor<bmp280>, "bmp280 must model bmp_sensor");
+#endif
+
 #endif
\ No newline at end of file
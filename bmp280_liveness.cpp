@@ -0,0 +1,122 @@
+/**
+ * @file bmp280_liveness.cpp
+ * @author Denys Khmil
+ * @brief This file contents the bmp280 hot-plug liveness manager
+ */
+#include "bmp280_liveness.h"
+
+/**
+ * @brief bmp280_liveness constructor with default backoff
+ * @param _sensors: managed sensors.
+ * @param _count: number of sensors (up to BMP280_LIVENESS_MAX_SENSORS).
+ */
+bmp280_liveness::bmp280_liveness(bmp280** _sensors, uint8_t _count)
+    : bmp280_liveness(_sensors, _count, BMP280_LIVENESS_MIN_BACKOFF, BMP280_LIVENESS_MAX_BACKOFF){
+}
+
+
+/**
+ * @brief bmp280_liveness constructor with specified backoff
+ * @param _sensors: managed sensors.
+ * @param _count: number of sensors (up to BMP280_LIVENESS_MAX_SENSORS).
+ * @param _min_backoff: first probe delay after a failure in ms.
+ * @param _max_backoff: longest probe delay in ms.
+ * @note All sensors start online
+ */
+bmp280_liveness::bmp280_liveness(bmp280** _sensors, uint8_t _count, uint32_t _min_backoff, uint32_t _max_backoff){
+    this->sensors = _sensors;
+    this->count = (_count > BMP280_LIVENESS_MAX_SENSORS) ? BMP280_LIVENESS_MAX_SENSORS : _count;
+    this->minBackoff = _min_backoff;
+    this->maxBackoff = _max_backoff;
+    for(uint8_t i = 0; i < this->count; i++){
+        this->online[i] = 1;
+        this->backoff[i] = _min_backoff;
+        this->lastProbe[i] = 0;
+        this->reconnectCount[i] = 0;
+    }
+}
+
+
+/**
+ * @brief Get temperature and pressure from an online sensor
+ * @param index: sensor index.
+ * @retval 1 if values were measured, 0 if sensor is offline
+ * @note Offline sensors cost no bus time until their next probe is due.
+ *       A successful probe restores sensor settings and calibration.
+ */
+uint8_t bmp280_liveness::getTempPressure(uint8_t index, double* temperature, double* pressure){
+    if(index >= this->count) return 0;
+    if(!this->online[index] && !this->probe(index)) return 0;
+
+    this->sensors[index]->getTempPressure(temperature, pressure);
+    if(this->sensors[index]->getStatus() != HAL_OK){
+        this->markOffline(index);
+        return 0;
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Check if sensor is online
+ * @param index: sensor index.
+ */
+uint8_t bmp280_liveness::isOnline(uint8_t index){
+    return (index < this->count) ? this->online[index] : 0;
+}
+
+
+/**
+ * @brief Number of online sensors
+ */
+uint8_t bmp280_liveness::onlineCount(){
+    uint8_t online_count = 0;
+    for(uint8_t i = 0; i < this->count; i++){
+        online_count += this->online[i];
+    }
+    return online_count;
+}
+
+
+/**
+ * @brief Number of times sensor came back online
+ * @param index: sensor index.
+ */
+uint16_t bmp280_liveness::reconnects(uint8_t index){
+    return (index < this->count) ? this->reconnectCount[index] : 0;
+}
+
+
+/**
+ * @brief Mark sensor offline after the first failed transfer
+ */
+void bmp280_liveness::markOffline(uint8_t index){
+    this->online[index] = 0;
+    this->backoff[index] = this->minBackoff;
+    this->lastProbe[index] = HAL_GetTick();
+}
+
+
+/**
+ * @brief Probe offline sensor with a chip id read when its backoff expired
+ * @retval 1 if sensor is back online
+ * @note Probe delay doubles after every failed probe up to maxBackoff
+ */
+uint8_t bmp280_liveness::probe(uint8_t index){
+    uint32_t now = HAL_GetTick();
+    if((now - this->lastProbe[index]) < this->backoff[index]) return 0;
+    this->lastProbe[index] = now;
+
+    bmp280* sensor = this->sensors[index];
+    uint8_t id = sensor->read_id();
+    if(sensor->getStatus() != HAL_OK || !bmp280::isChipId(id)){
+        this->backoff[index] = (this->backoff[index] > this->maxBackoff / 2) ? this->maxBackoff : this->backoff[index] * 2;
+        return 0;
+    }
+
+    sensor->restore();
+    if(sensor->getStatus() != HAL_OK) return 0;
+    this->online[index] = 1;
+    this->reconnectCount[index]++;
+    return 1;
+}
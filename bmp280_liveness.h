@@ -0,0 +1,48 @@
+/**
+ * @file bmp280_liveness.h
+ * @author Denys Khmil
+ * @brief This file contents the bmp280_liveness class
+ */
+#ifndef BMP280_LIVENESS
+#define BMP280_LIVENESS
+
+#include "bmp280_lib.h"
+
+#define BMP280_LIVENESS_MAX_SENSORS 16
+#define BMP280_LIVENESS_MIN_BACKOFF 10
+#define BMP280_LIVENESS_MAX_BACKOFF 5000
+
+class bmp280_liveness{
+public:
+    /*CONSTRUCTORS*/
+    bmp280_liveness(bmp280** _sensors, uint8_t _count);
+    bmp280_liveness(bmp280** _sensors, uint8_t _count, uint32_t _min_backoff, uint32_t _max_backoff);
+
+    /*MEASURINGS*/
+    uint8_t getTempPressure(uint8_t index, double* temperature, double* pressure);
+
+    /*STATE*/
+    uint8_t isOnline(uint8_t index);
+    uint8_t onlineCount();
+    uint16_t reconnects(uint8_t index);
+
+private:
+    void markOffline(uint8_t index);
+    uint8_t probe(uint8_t index);
+
+    /*SENSORS*/
+    bmp280** sensors;
+    uint8_t count;
+
+    /*BACKOFF PARAMETERS*/
+    uint32_t minBackoff;
+    uint32_t maxBackoff;
+
+    /*SENSOR STATE*/
+    uint8_t online[BMP280_LIVENESS_MAX_SENSORS];
+    uint32_t backoff[BMP280_LIVENESS_MAX_SENSORS];
+    uint32_t lastProbe[BMP280_LIVENESS_MAX_SENSORS];
+    uint16_t reconnectCount[BMP280_LIVENESS_MAX_SENSORS];
+};
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file bmp280_model.cpp
+ * @author Denys Khmil
+ * @brief This file contents the bmp280 timing and energy model functions
+ */
+#include "bmp280_model.h"
+
+/**
+ * @brief Number of conversions for osrs register value
+ * @param osrs: 0b000 = skipped, 0b001 = x1 .. 0b101 and above = x16.
+ */
+uint8_t bmp280_oversampling(uint8_t osrs){
+    if(osrs == 0) return 0;
+    if(osrs > 5) osrs = 5;
+    return (uint8_t)(1 << (osrs - 1));
+}
+
+
+/**
+ * @brief Typical measurement time
+ * @param osrs_p: Pressure measurement settings register.
+ * @param osrs_t: Temperature measurement settings register.
+ * @retval Time in us: 1 ms + 2 ms per temperature conversion + 2 ms per pressure conversion + 0.5 ms
+ */
+uint32_t bmp280_measurementTime(uint8_t osrs_p, uint8_t osrs_t){
+    uint32_t time = 1000 + 2000 * (uint32_t)bmp280_oversampling(osrs_t);
+    if(osrs_p) time += 2000 * (uint32_t)bmp280_oversampling(osrs_p) + 500;
+    return time;
+}
+
+
+/**
+ * @brief Standby time of normal mode
+ * @param t_sb: Standby time setting (0b000 .. 0b111).
+ * @param bme280: 1 for BME280, where 0b110 and 0b111 are 10 ms and 20 ms instead of 2 s and 4 s.
+ * @retval Time in us
+ */
+uint32_t bmp280_standbyTime(uint8_t t_sb, uint8_t bme280){
+    static const uint32_t standby[8] = {500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000};
+    static const uint32_t standby_bme280[8] = {500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000};
+    return bme280 ? standby_bme280[t_sb & 0x07] : standby[t_sb & 0x07];
+}
+
+
+/**
+ * @brief Sample period of normal mode
+ * @retval Time in us
+ */
+uint32_t bmp280_samplePeriod(uint8_t osrs_p, uint8_t osrs_t, uint8_t t_sb, uint8_t bme280){
+    return bmp280_measurementTime(osrs_p, osrs_t) + bmp280_standbyTime(t_sb, bme280);
+}
+
+
+/**
+ * @brief Samples until the chip IIR filter reaches 75% of a step
+ * @param filter: IIR filter setting (0b000 = off .. 0b100 = 16).
+ */
+uint8_t bmp280_filterSettleSamples(uint8_t filter){
+    static const uint8_t settle[5] = {1, 2, 5, 11, 22};
+    return settle[(filter > 4) ? 4 : filter];
+}
+
+
+/**
+ * @brief Charge of one measurement
+ * @param osrs_h: Humidity measurement settings register (0 for bmp280).
+ * @retval Charge in nC (uA * ms) above the standby current
+ * @note 1 ms start-up is charged at the temperature current, humidity adds 2 ms per conversion + 0.5 ms
+ */
+uint32_t bmp280_measurementCharge(uint8_t osrs_p, uint8_t osrs_t, uint8_t osrs_h){
+    uint32_t charge = BMP280_IDD_TEMPERATURE * (1000 + 2000 * (uint32_t)bmp280_oversampling(osrs_t));
+    if(osrs_p) charge += BMP280_IDD_PRESSURE * (2000 * (uint32_t)bmp280_oversampling(osrs_p) + 500);
+    if(osrs_h) charge += BME280_IDD_HUMIDITY * (2000 * (uint32_t)bmp280_oversampling(osrs_h) + 500);
+    return charge / 1000;
+}
+
+
+/**
+ * @brief Average sensor current in normal mode
+ * @retval Current in nA
+ */
+uint32_t bmp280_averageCurrent(uint8_t osrs_p, uint8_t osrs_t, uint8_t t_sb, uint8_t bme280){
+    uint32_t period = bmp280_samplePeriod(osrs_p, osrs_t, t_sb, bme280);
+    return (uint32_t)((uint64_t)bmp280_measurementCharge(osrs_p, osrs_t, 0) * 1000000 / period) + BMP280_IDD_STANDBY_NA;
+}
+
+
+/**
+ * @brief Energy of one register transfer
+ * @param bytes: data bytes (address, register and restart are added).
+ * @retval Energy in nJ
+ */
+uint32_t bmp280_transferEnergy(const bmp280_bus_model* bus, uint16_t bytes){
+    uint64_t bits = (uint64_t)(bytes + 3) * 9 + 3;
+    uint64_t time_ns = bits * 1000000000ULL / bus->clock;
+    return (uint32_t)(time_ns * bus->vdd_mv * bus->current_ua / 1000000000ULL);
+}
+
+
+/**
+ * @brief Estimate sensor current and energy per sample of a configuration
+ * @param ctrl_meas: ctrl_meas register (0xF4).
+ * @param config: config register (0xF5).
+ * @param ctrl_hum: ctrl_hum register (0xF2), 0 for bmp280.
+ * @param bus: bus parameters.
+ * @param polls: status reads per sample.
+ * @param forced_period_us: sample period in forced mode (ignored in normal mode).
+ * @param energy: estimate.
+ * @param bme280: 1 for BME280 (standby table, see bmp280_standbyTime()).
+ * @note In forced mode every sample also costs the ctrl_meas write that starts it
+ */
+void bmp280_estimateEnergy(uint8_t ctrl_meas, uint8_t config, uint8_t ctrl_hum, const bmp280_bus_model* bus,
+                           uint8_t polls, uint32_t forced_period_us, bmp280_energy* energy, uint8_t bme280){
+    uint8_t osrs_t = (ctrl_meas >> 5) & 0x07;
+    uint8_t osrs_p = (ctrl_meas >> 2) & 0x07;
+    uint8_t mode = ctrl_meas & 0x03;
+    uint8_t osrs_h = ctrl_hum & 0x07;
+    uint32_t charge = bmp280_measurementCharge(osrs_p, osrs_t, osrs_h);
+    uint32_t measurement = bmp280_measurementTime(osrs_p, osrs_t);
+    if(osrs_h) measurement += 2000 * (uint32_t)bmp280_oversampling(osrs_h) + 500;
+
+    uint32_t idle_na;
+    if(mode == BMP280_MODE_NORMAL){
+        energy->period_us = measurement + bmp280_standbyTime(config >> 5, bme280);
+        idle_na = BMP280_IDD_STANDBY_NA;
+    }
+    else if(mode == BMP280_MODE_SLEEP){
+        energy->period_us = 0;
+        energy->sensor_na = BMP280_IDD_SLEEP_NA;
+        energy->sensor_nj = 0;
+        energy->bus_nj = 0;
+        return;
+    }
+    else{
+        energy->period_us = (forced_period_us > measurement) ? forced_period_us : measurement;
+        idle_na = BMP280_IDD_SLEEP_NA;
+    }
+
+    energy->sensor_na = (uint32_t)((uint64_t)charge * 1000000 / energy->period_us) + idle_na;
+    energy->sensor_nj = (uint32_t)((uint64_t)energy->sensor_na * energy->period_us * bus->vdd_mv / 1000000000ULL);
+    energy->bus_nj = bmp280_transferEnergy(bus, osrs_h ? 8 : 6) + polls * bmp280_transferEnergy(bus, 1);
+    if(mode != BMP280_MODE_NORMAL) energy->bus_nj += bmp280_transferEnergy(bus, 1);
+}
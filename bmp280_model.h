@@ -0,0 +1,62 @@
+/**
+ * @file bmp280_model.h
+ * @author Denys Khmil
+ * @brief This file contents the hardware independent bmp280 timing and energy model (datasheet typical values)
+ */
+#ifndef BMP280_MODEL
+#define BMP280_MODEL
+
+#include <stdint.h>
+
+/*MODES*/
+#define BMP280_MODE_SLEEP   0b00
+#define BMP280_MODE_FORCED  0b01
+#define BMP280_MODE_NORMAL  0b11
+
+/*CURRENTS (datasheet typical, uA)*/
+#define BMP280_IDD_PRESSURE         720
+#define BMP280_IDD_TEMPERATURE      325
+#define BME280_IDD_HUMIDITY         340
+#define BMP280_IDD_STANDBY_NA       200
+#define BMP280_IDD_SLEEP_NA         100
+
+/*BUS DEFAULTS*/
+#define BMP280_BUS_VDD_MV           3300
+#define BMP280_BUS_CURRENT_UA       700
+
+/**
+ * @brief I2C bus parameters for the transfer energy estimate
+ * @note current is the average supply current while the bus is active (pull-ups and drivers)
+ */
+struct bmp280_bus_model{
+    uint32_t clock;
+    uint16_t vdd_mv;
+    uint16_t current_ua;
+};
+
+/**
+ * @brief Energy estimate of one configuration
+ * @note sensor_na is the average sensor current, sensor_nj and bus_nj the energy per sample
+ */
+struct bmp280_energy{
+    uint32_t period_us;
+    uint32_t sensor_na;
+    uint32_t sensor_nj;
+    uint32_t bus_nj;
+};
+
+/*TIMING FUNCTIONS*/
+uint8_t bmp280_oversampling(uint8_t osrs);
+uint32_t bmp280_measurementTime(uint8_t osrs_p, uint8_t osrs_t);
+uint32_t bmp280_standbyTime(uint8_t t_sb, uint8_t bme280 = 0);
+uint32_t bmp280_samplePeriod(uint8_t osrs_p, uint8_t osrs_t, uint8_t t_sb, uint8_t bme280 = 0);
+uint8_t bmp280_filterSettleSamples(uint8_t filter);
+
+/*ENERGY FUNCTIONS*/
+uint32_t bmp280_measurementCharge(uint8_t osrs_p, uint8_t osrs_t, uint8_t osrs_h);
+uint32_t bmp280_averageCurrent(uint8_t osrs_p, uint8_t osrs_t, uint8_t t_sb, uint8_t bme280 = 0);
+uint32_t bmp280_transferEnergy(const bmp280_bus_model* bus, uint16_t bytes);
+void bmp280_estimateEnergy(uint8_t ctrl_meas, uint8_t config, uint8_t ctrl_hum, const bmp280_bus_model* bus,
+                           uint8_t polls, uint32_t forced_period_us, bmp280_energy* energy, uint8_t bme280 = 0);
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * @file bmp388_compensate.cpp
+ * @author Denys Khmil
+ * @brief This file contents the hardware independent bmp388/bmp390 functions
+ */
+#include "bmp388_compensate.h"
+
+/**
+ * @brief Decode calibration registers
+ * @param regs: 21 bytes read from 0x31.
+ * @param calib: decoded constants.
+ */
+void bmp388_parseCalibration(const uint8_t* regs, bmp388_calib* calib){
+    calib->par_t1 = uint16_t(regs[1] << 8)|uint16_t(regs[0]);
+    calib->par_t2 = uint16_t(regs[3] << 8)|uint16_t(regs[2]);
+    calib->par_t3 = int8_t(regs[4]);
+    calib->par_p1 = int16_t(uint16_t(regs[6] << 8)|uint16_t(regs[5]));
+    calib->par_p2 = int16_t(uint16_t(regs[8] << 8)|uint16_t(regs[7]));
+    calib->par_p3 = int8_t(regs[9]);
+    calib->par_p4 = int8_t(regs[10]);
+    calib->par_p5 = uint16_t(regs[12] << 8)|uint16_t(regs[11]);
+    calib->par_p6 = uint16_t(regs[14] << 8)|uint16_t(regs[13]);
+    calib->par_p7 = int8_t(regs[15]);
+    calib->par_p8 = int8_t(regs[16]);
+    calib->par_p9 = int16_t(uint16_t(regs[18] << 8)|uint16_t(regs[17]));
+    calib->par_p10 = int8_t(regs[19]);
+    calib->par_p11 = int8_t(regs[20]);
+    calib->t_lin = 0;
+}
+
+
+/**
+ * @brief Compensate temperature with integer arithmetic, updates t_lin
+ * @retval Temperature in 0.01 degC
+ */
+int32_t bmp388_compensateTemp(bmp388_calib* calib, uint32_t temp_raw){
+    int64_t partial_data1 = (int64_t)temp_raw - ((int64_t)256 * calib->par_t1);
+    int64_t partial_data2 = (int64_t)calib->par_t2 * partial_data1;
+    int64_t partial_data3 = partial_data1 * partial_data1;
+    int64_t partial_data4 = partial_data3 * calib->par_t3;
+    int64_t partial_data5 = (partial_data2 * 262144) + partial_data4;
+    calib->t_lin = partial_data5 / 4294967296LL;
+    return (int32_t)((calib->t_lin * 25) / 16384);
+}
+
+
+/**
+ * @brief Compensate pressure with integer arithmetic, uses t_lin of the last temperature
+ * @retval Pressure in 0.01 Pa
+ */
+uint32_t bmp388_compensatePressure(const bmp388_calib* calib, uint32_t pres_raw){
+    int64_t t_lin = calib->t_lin;
+    int64_t pressure = pres_raw;
+
+    int64_t partial_data1 = t_lin * t_lin;
+    int64_t partial_data2 = partial_data1 / 64;
+    int64_t partial_data3 = (partial_data2 * t_lin) / 256;
+    int64_t partial_data4 = (calib->par_p8 * partial_data3) / 32;
+    int64_t partial_data5 = (calib->par_p7 * partial_data1) * 16;
+    int64_t partial_data6 = (calib->par_p6 * t_lin) * 4194304;
+    int64_t offset = ((int64_t)calib->par_p5 * 140737488355328LL) + partial_data4 + partial_data5 + partial_data6;
+
+    partial_data2 = (calib->par_p4 * partial_data3) / 32;
+    partial_data4 = (calib->par_p3 * partial_data1) * 4;
+    partial_data5 = ((int64_t)calib->par_p2 - 16384) * t_lin * 2097152;
+    int64_t sensitivity = (((int64_t)calib->par_p1 - 16384) * 70368744177664LL) + partial_data2 + partial_data4 + partial_data5;
+
+    partial_data1 = (sensitivity / 16777216) * pressure;
+    partial_data2 = calib->par_p10 * t_lin;
+    partial_data3 = partial_data2 + ((int64_t)65536 * calib->par_p9);
+    partial_data4 = (partial_data3 * pressure) / 8192;
+    partial_data5 = (pressure * (partial_data4 / 10)) / 512; // divided by 10 to avoid overflow
+    partial_data5 = partial_data5 * 10;
+    partial_data6 = pressure * pressure;
+    partial_data2 = (calib->par_p11 * partial_data6) / 65536;
+    partial_data3 = (partial_data2 * pressure) / 128;
+    partial_data4 = (offset / 4) + partial_data1 + partial_data5 + partial_data3;
+
+    return (uint32_t)(((uint64_t)partial_data4 * 25) / 1099511627776ULL);
+}
+
+
+/**
+ * @brief Compensate raw frame to the common sample format
+ * @param calib: sensor calibration.
+ * @param raw: uncompensated values.
+ * @param sample: compensated values (see bmp_sample).
+ */
+void bmp388_compensate(bmp388_calib* calib, const bmp_raw* raw, bmp_sample* sample){
+    sample->temperature = bmp388_compensateTemp(calib, (uint32_t)raw->temperature);
+    sample->pressure = (uint32_t)(((uint64_t)bmp388_compensatePressure(calib, (uint32_t)raw->pressure) * 64) / 25);
+    sample->humidity = 0;
+}
+
+
+/**
+ * @brief Parse fifo content into raw frames
+ * @param data: bytes read from FIFO_DATA.
+ * @param length: number of bytes.
+ * @param frames: parsed frames.
+ * @param max_frames: size of frames storage.
+ * @param last_temperature: temperature for pressure-only frames, updated by temperature frames.
+ * @param consumed: number of parsed bytes, parsing continues from here when frames storage was full.
+ * @retval Number of parsed frames
+ * @note Parsing stops at an empty frame, an unknown header or a truncated frame
+ */
+uint16_t bmp388_parseFifo(const uint8_t* data, uint16_t length, bmp_raw* frames, uint16_t max_frames, int32_t* last_temperature, uint16_t* consumed){
+    uint16_t index = 0;
+    uint16_t count = 0;
+    *consumed = length;
+
+    while(index < length){
+        uint8_t header = data[index];
+        uint8_t size;
+        switch(header){
+            case BMP388_FIFO_TEMP_PRESS: size = 6; break;
+            case BMP388_FIFO_TEMP:
+            case BMP388_FIFO_PRESS:
+            case BMP388_FIFO_TIME: size = 3; break;
+            case BMP388_FIFO_CONFIG_CHG:
+            case BMP388_FIFO_CONFIG_ERR: size = 1; break;
+            default: return count;
+        }
+        if(index + 1 + size > length) return count;
+        if(count == max_frames) break;
+
+        const uint8_t* payload = &data[index + 1];
+        index += 1 + size;
+        if(header == BMP388_FIFO_TEMP || header == BMP388_FIFO_TEMP_PRESS){
+            *last_temperature = (int32_t)((uint32_t(payload[2]) << 16)|(uint32_t(payload[1]) << 8)|payload[0]);
+            if(header == BMP388_FIFO_TEMP) continue;
+            payload += 3;
+        }
+        else if(header != BMP388_FIFO_PRESS){
+            continue;
+        }
+
+        frames[count].temperature = *last_temperature;
+        frames[count].pressure = (int32_t)((uint32_t(payload[2]) << 16)|(uint32_t(payload[1]) << 8)|payload[0]);
+        frames[count].humidity = 0;
+        count++;
+    }
+    *consumed = index;
+    return count;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file bmp388_compensate.h
+ * @author Denys Khmil
+ * @brief This file contents the hardware independent bmp388/bmp390 calibration, compensation and fifo parser
+ */
+#ifndef BMP388_COMPENSATE
+#define BMP388_COMPENSATE
+
+#include <stdint.h>
+#include "bmp_sample.h"
+
+/*CALIBRATION*/
+#define BMP388_CALIB_ADDR   0x31
+#define BMP388_CALIB_LENGTH 21
+
+/*FIFO FRAME HEADERS*/
+#define BMP388_FIFO_TEMP_PRESS  0x94
+#define BMP388_FIFO_TEMP        0x90
+#define BMP388_FIFO_PRESS       0x84
+#define BMP388_FIFO_TIME        0xA0
+#define BMP388_FIFO_EMPTY       0x80
+#define BMP388_FIFO_CONFIG_CHG  0x48
+#define BMP388_FIFO_CONFIG_ERR  0x44
+
+/**
+ * @brief bmp388 calibration constants as stored in NVM (0x31..0x45)
+ * @note t_lin is updated by every temperature compensation
+ */
+struct bmp388_calib{
+    uint16_t par_t1;
+    uint16_t par_t2;
+    int8_t par_t3;
+    int16_t par_p1;
+    int16_t par_p2;
+    int8_t par_p3;
+    int8_t par_p4;
+    uint16_t par_p5;
+    uint16_t par_p6;
+    int8_t par_p7;
+    int8_t par_p8;
+    int16_t par_p9;
+    int8_t par_p10;
+    int8_t par_p11;
+    int64_t t_lin;
+};
+
+/*CALIBRATION FUNCTIONS*/
+void bmp388_parseCalibration(const uint8_t* regs, bmp388_calib* calib);
+
+/*CONVERT FUNCTIONS*/
+int32_t bmp388_compensateTemp(bmp388_calib* calib, uint32_t temp_raw);
+uint32_t bmp388_compensatePressure(const bmp388_calib* calib, uint32_t pres_raw);
+void bmp388_compensate(bmp388_calib* calib, const bmp_raw* raw, bmp_sample* sample);
+
+/*FIFO FUNCTIONS*/
+uint16_t bmp388_parseFifo(const uint8_t* data, uint16_t length, bmp_raw* frames, uint16_t max_frames, int32_t* last_temperature, uint16_t* consumed);
+
+#endif
@@ -0,0 +1,341 @@
+/**
+ * @file bmp388_lib.cpp
+ * @author Denys Khmil
+ * @brief This file contents all the bmp388 library functions
+ */
+#include "bmp388_lib.h"
+
+/**
+ * @brief bmp388 constructor with specified i2c address
+ * @param _i2c: bmp388 i2c port.
+ * @param _address bmp388 address.
+ * @note Saves i2c port and adress, sets bmp388 to default mode (pressure oversampling*4, normal mode, 50 Hz)
+ */
+bmp388::bmp388(I2C_HandleTypeDef _i2c, uint8_t _address) : bmp388(){
+    this->init(_i2c, _address);
+}
+
+
+/**
+ * @brief bmp388 constructor with defauld i2c address
+ * @param _i2c: bmp388 i2c port.
+ * @note Saves i2c port and adress, sets bmp388 to default mode (pressure oversampling*4, normal mode, 50 Hz)
+ */
+bmp388::bmp388(I2C_HandleTypeDef _i2c) : bmp388(){
+    this->init(_i2c, BMP388_ADDRESS_PRIMARY);
+}
+
+
+/**
+ * @brief bmp388 constructor without i2c transfers
+ * @note Sensor must be initialized with init() before use
+ */
+bmp388::bmp388(){
+    this->address = BMP388_ADDRESS_PRIMARY;
+    this->chipId = 0;
+    this->busClock = BMP388_I2C_SM_CLOCK;
+    this->status = HAL_OK;
+    this->pwrCtrl = 0;
+    this->osr = 0;
+    this->odr = 0;
+    this->configReg = 0;
+    this->fifoConfig1 = 0;
+    this->fifoConfig2 = 0;
+    this->fifoWatermark = 0;
+    this->fifoTemperature = 0;
+}
+
+
+/**
+ * @brief Initialize sensor on specified i2c port and address
+ * @param _i2c: bmp388 i2c port.
+ * @param _address bmp388 address.
+ */
+void bmp388::init(I2C_HandleTypeDef _i2c, uint8_t _address){
+    this->i2c = _i2c;
+    this->address = _address;
+    this->read_id();
+    this->readCalibration();
+    this->setConfig(0x02, 0);
+    this->settings(0b010, 0b000, 0b11);
+}
+
+
+/**
+ * @brief Changes sensor settings
+ * @param osr_p: Pressure oversampling (0 = x1 .. 5 = x32).
+ * @param osr_t: Temperature oversampling (0 = x1 .. 5 = x32).
+ * @param mode: Sensor mode (0b00 sleep, 0b01 forced, 0b11 normal).
+ * @note Pressure and temperature are always enabled
+ */
+void bmp388::settings(uint8_t osr_p, uint8_t osr_t, uint8_t mode){
+    this->osr = ((osr_t & 0x07) << 3)|(osr_p & 0x07);
+    this->pwrCtrl = ((mode & 0x03) << 4)|0x03;
+    this->writeRegister(0x1C, this->osr);
+    this->writeRegister(0x1B, this->pwrCtrl);
+}
+
+
+/**
+ * @brief Set output data rate and IIR filter
+ * @param odr: ODR prescaler (0 = 200 Hz, rate halves per step up to 17).
+ * @param filter: IIR filter coefficient (0 = off, 1..7 = 1, 3, 7, 15, 31, 63, 127).
+ */
+void bmp388::setConfig(uint8_t odr, uint8_t filter){
+    this->odr = odr & 0x1F;
+    this->configReg = (filter & 0x07) << 1;
+    this->writeRegister(0x1D, this->odr);
+    this->writeRegister(0x1F, this->configReg);
+}
+
+
+/**
+ * @brief Software reset for sensor
+ */
+void bmp388::Reset(){
+    this->writeRegister(0x7E, 0xB6);
+}
+
+
+/**
+ * @brief Read sensor id (0x50 for BMP388, 0x60 for BMP390)
+ * @retval id uint8_t
+ */
+uint8_t bmp388::read_id(){
+    uint8_t id = 0;
+    if(this->readRegisters(0x00, &id, 1) == HAL_OK){
+        this->chipId = id;
+    }
+    return id;
+}
+
+
+/**
+ * @brief Check if id belongs to bmp388 family
+ * @param id: value of id register.
+ * @retval 1 for BMP388 (0x50) and BMP390 (0x60), 0 otherwise
+ */
+uint8_t bmp388::isChipId(uint8_t id){
+    return (id == BMP388_CHIP_ID) || (id == BMP390_CHIP_ID);
+}
+
+
+/**
+ * @brief Restore settings, fifo and calibration after sensor power loss
+ */
+void bmp388::restore(){
+    this->readCalibration();
+    this->writeRegister(0x1D, this->odr);
+    this->writeRegister(0x1F, this->configReg);
+    this->writeRegister(0x15, (uint8_t)(this->fifoWatermark & 0xFF));
+    this->writeRegister(0x16, (uint8_t)(this->fifoWatermark >> 8));
+    this->writeRegister(0x18, this->fifoConfig2);
+    this->writeRegister(0x17, this->fifoConfig1);
+    this->writeRegister(0x1C, this->osr);
+    this->writeRegister(0x1B, this->pwrCtrl);
+}
+
+
+/**
+ * @brief Get status of the last i2c transfer
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp388::getStatus(){
+    return this->status;
+}
+
+
+/**
+ * @brief Set i2c bus clock used for timeouts
+ * @param clock: bus clock in Hz, 0 is ignored.
+ */
+void bmp388::setBusClock(uint32_t clock){
+    if(!clock) return;
+    this->busClock = clock;
+}
+
+
+/**
+ * @brief Enable fifo with pressure and temperature frames
+ * @param watermark_frames: frames stored before the watermark interrupt (0 disables the fifo).
+ * @param subsampling: fifo stores every 2^subsampling-th measurement.
+ * @note Watermark interrupt is enabled on INT pin, sensortime frames are disabled
+ */
+void bmp388::setFifo(uint16_t watermark_frames, uint8_t subsampling){
+    if(watermark_frames > BMP388_FIFO_MAX_FRAMES) watermark_frames = BMP388_FIFO_MAX_FRAMES;
+    this->fifoWatermark = watermark_frames * BMP388_FIFO_FRAME_SIZE;
+    this->fifoConfig1 = watermark_frames ? 0x19 : 0x00;
+    this->fifoConfig2 = (0x01 << 3)|(subsampling & 0x07);
+    this->writeRegister(0x15, (uint8_t)(this->fifoWatermark & 0xFF));
+    this->writeRegister(0x16, (uint8_t)(this->fifoWatermark >> 8));
+    this->writeRegister(0x18, this->fifoConfig2);
+    this->writeRegister(0x17, this->fifoConfig1);
+    this->writeRegister(0x19, watermark_frames ? 0x08 : 0x00);
+    this->fifoTemperature = 0;
+}
+
+
+/**
+ * @brief Discard all fifo frames
+ */
+void bmp388::flushFifo(){
+    this->writeRegister(0x7E, 0xB0);
+}
+
+
+/**
+ * @brief Read number of bytes stored in fifo
+ */
+uint16_t bmp388::fifoLength(){
+    uint8_t buffer[2] = {0, 0};
+    this->readRegisters(0x12, buffer, 2);
+    return (uint16_t)(((buffer[1] & 0x01) << 8)|buffer[0]);
+}
+
+
+/**
+ * @brief Drain fifo in one burst and compensate all frames
+ * @param samples: compensated samples, oldest first.
+ * @param max_samples: size of samples storage.
+ * @retval Number of samples
+ * @note Costs two transactions regardless of the number of frames. The whole fifo is read,
+ *       so no frame is split between reads; frames beyond max_samples are dropped, their
+ *       temperature is still kept for following pressure-only frames
+ */
+uint16_t bmp388::readFifo(bmp_sample* samples, uint16_t max_samples){
+    uint16_t length = this->fifoLength();
+    if(this->status != HAL_OK || length == 0) return 0;
+    if(length > BMP388_FIFO_SIZE) length = BMP388_FIFO_SIZE;
+    if(this->readRegisters(0x14, this->fifoBuffer, length) != HAL_OK) return 0;
+
+    bmp_raw frames[BMP388_FIFO_PARSE_CHUNK];
+    uint16_t count = 0;
+    uint16_t index = 0;
+    while(index < length){
+        uint16_t consumed;
+        uint16_t parsed = bmp388_parseFifo(&this->fifoBuffer[index], length - index, frames, BMP388_FIFO_PARSE_CHUNK, &this->fifoTemperature, &consumed);
+        for(uint16_t i = 0; i < parsed && count < max_samples; i++){
+            this->compensate(&frames[i], &samples[count++]);
+        }
+        index += consumed;
+        if(parsed < BMP388_FIFO_PARSE_CHUNK) break;
+    }
+    return count;
+}
+
+
+/**
+ * @brief Get temperature and pressure from sensor
+ */
+void bmp388::getTempPressure(double* temperature, double* pressure){
+    bmp_sample sample;
+    this->getSample(&sample);
+    *temperature = sample.temperature/BMP_TEMPERATURE_SCALE;
+    *pressure = sample.pressure/BMP_PRESSURE_SCALE;
+}
+
+
+/**
+ * @brief Get temperature from sensor
+ * @retval Temperature (double)
+ */
+double bmp388::getTemperature(){
+    double temperature, pressure;
+    this->getTempPressure(&temperature, &pressure);
+    return temperature;
+}
+
+
+/**
+ * @brief Get pressure from sensor
+ * @retval Pressure (double)
+ */
+double bmp388::getPressure(){
+    double temperature, pressure;
+    this->getTempPressure(&temperature, &pressure);
+    return pressure;
+}
+
+
+/**
+ * @brief Read all the data registers in one burst (0x04..0x09)
+ * @param raw: uncompensated values.
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp388::readRaw(bmp_raw* raw){
+    uint8_t buffer[6];
+    HAL_StatusTypeDef result = this->readRegisters(0x04, buffer, 6);
+    raw->pressure = (int32_t)((uint32_t(buffer[2]) << 16)|(uint32_t(buffer[1]) << 8)|buffer[0]);
+    raw->temperature = (int32_t)((uint32_t(buffer[5]) << 16)|(uint32_t(buffer[4]) << 8)|buffer[3]);
+    raw->humidity = 0;
+    return result;
+}
+
+
+/**
+ * @brief Compensate raw values with integer arithmetic only
+ * @param raw: uncompensated values.
+ * @param sample: compensated values (see bmp_sample).
+ */
+void bmp388::compensate(const bmp_raw* raw, bmp_sample* sample){
+    bmp388_compensate(&this->calib, raw, sample);
+}
+
+
+/**
+ * @brief Get fixed-point sample from sensor
+ * @param sample: compensated values (see bmp_sample).
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp388::getSample(bmp_sample* sample){
+    bmp_raw raw;
+    HAL_StatusTypeDef result = this->readRaw(&raw);
+    this->compensate(&raw, sample);
+    return result;
+}
+
+
+/**
+ * @brief Read calibration constants from sensor in one burst
+ */
+void bmp388::readCalibration(){
+    uint8_t buffer[BMP388_CALIB_LENGTH];
+    this->readRegisters(BMP388_CALIB_ADDR, buffer, BMP388_CALIB_LENGTH);
+    bmp388_parseCalibration(buffer, &this->calib);
+}
+
+
+/**
+ * @brief Read sensor registers
+ * @param reg: first register address.
+ * @param buffer: destination buffer.
+ * @param length: number of bytes to read.
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp388::readRegisters(uint8_t reg, uint8_t* buffer, uint16_t length){
+    this->status = HAL_I2C_Mem_Read(&this->i2c, (uint16_t)(this->address << 1), reg, I2C_MEMADD_SIZE_8BIT, buffer, length, this->timeout(length));
+    return this->status;
+}
+
+
+/**
+ * @brief Write sensor register
+ * @param reg: register address.
+ * @param value: register value.
+ * @retval HAL status
+ */
+HAL_StatusTypeDef bmp388::writeRegister(uint8_t reg, uint8_t value){
+    this->status = HAL_I2C_Mem_Write(&this->i2c, (uint16_t)(this->address << 1), reg, I2C_MEMADD_SIZE_8BIT, &value, 1, this->timeout(1));
+    return this->status;
+}
+
+
+/**
+ * @brief Transfer timeout scaled to the bus clock
+ * @param length: number of data bytes.
+ * @retval Timeout in ms
+ */
+uint32_t bmp388::timeout(uint16_t length){
+    uint32_t bits = (uint32_t)(length + 3) * 9;
+    return (2 * bits * 1000) / this->busClock + 2;
+}
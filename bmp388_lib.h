@@ -0,0 +1,99 @@
+/**
+ * @file bmp388_lib.h
+ * @author Denys Khmil
+ * @brief This file contents the bmp388 class (BMP388/BMP390)
+ */
+#ifndef BMP388_LIB
+#define BMP388_LIB
+
+#include "main.h"
+#include "bmp_sample.h"
+#include "bmp_sensor.h"
+#include "bmp388_compensate.h"
+
+/*I2C*/
+#define BMP388_ADDRESS_PRIMARY      0x76
+#define BMP388_ADDRESS_SECONDARY    0x77
+#define BMP388_I2C_SM_CLOCK         100000UL
+
+/*CHIP IDS*/
+#define BMP388_CHIP_ID      0x50
+#define BMP390_CHIP_ID      0x60
+
+/*FIFO*/
+#define BMP388_FIFO_SIZE        512
+#define BMP388_FIFO_FRAME_SIZE  7
+#define BMP388_FIFO_MAX_FRAMES  (BMP388_FIFO_SIZE / BMP388_FIFO_FRAME_SIZE)
+#define BMP388_FIFO_PARSE_CHUNK 8
+
+class bmp388{
+public:
+    /*CONSTRUCTORS*/
+    bmp388(I2C_HandleTypeDef _i2c, uint8_t _address);
+    bmp388(I2C_HandleTypeDef _i2c);
+    bmp388();
+    void init(I2C_HandleTypeDef _i2c, uint8_t _address);
+
+    /*UTILITY FUNCTIONS*/
+    void settings(uint8_t osr_p, uint8_t osr_t, uint8_t mode);
+    void setConfig(uint8_t odr, uint8_t filter);
+    void Reset();
+    uint8_t read_id();
+    static uint8_t isChipId(uint8_t id);
+    void restore();
+    HAL_StatusTypeDef getStatus();
+    void setBusClock(uint32_t clock);
+
+    /*FIFO FUNCTIONS*/
+    void setFifo(uint16_t watermark_frames, uint8_t subsampling);
+    void flushFifo();
+    uint16_t fifoLength();
+    uint16_t readFifo(bmp_sample* samples, uint16_t max_samples);
+
+    /*MEASURINGS*/
+    void getTempPressure(double* temperature, double* pressure);
+    double getTemperature();
+    double getPressure();
+
+    /*FIXED-POINT MEASURINGS*/
+    HAL_StatusTypeDef readRaw(bmp_raw* raw);
+    void compensate(const bmp_raw* raw, bmp_sample* sample);
+    HAL_StatusTypeDef getSample(bmp_sample* sample);
+
+private:
+    void readCalibration();
+
+    /*TRANSPORT FUNCTIONS*/
+    HAL_StatusTypeDef readRegisters(uint8_t reg, uint8_t* buffer, uint16_t length);
+    HAL_StatusTypeDef writeRegister(uint8_t reg, uint8_t value);
+    uint32_t timeout(uint16_t length);
+
+    /*SENSOR PARAMETERS*/
+    I2C_HandleTypeDef i2c;
+    uint8_t address;
+    uint8_t chipId;
+    uint32_t busClock;
+    HAL_StatusTypeDef status;
+
+    /*REGISTER SHADOWS*/
+    uint8_t pwrCtrl;
+    uint8_t osr;
+    uint8_t odr;
+    uint8_t configReg;
+    uint8_t fifoConfig1;
+    uint8_t fifoConfig2;
+    uint16_t fifoWatermark;
+
+    /*CALIBRATION CONSTANTS*/
+    bmp388_calib calib;
+
+    /*FIFO STATE*/
+    int32_t fifoTemperature;
+    uint8_t fifoBuffer[BMP388_FIFO_SIZE];
+};
+
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+static_assert(bmp_sensor<bmp388>, "bmp388 must model bmp_sensor");
+#endif
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * @file bmp_event.cpp
+ * @author Denys Khmil
+ * @brief This file contents the event detector functions
+ */
+#include "bmp_event.h"
+
+/**
+ * @brief Detector without rules
+ */
+bmp_event::bmp_event(){
+    this->count = 0;
+    this->flags.store(0);
+}
+
+
+/**
+ * @brief Add threshold rule
+ * @param channel: BMP_EVENT_TEMPERATURE, BMP_EVENT_PRESSURE or BMP_EVENT_HUMIDITY.
+ * @param type: BMP_EVENT_ABOVE fires when the value rises to level, BMP_EVENT_BELOW when it falls to level.
+ * @param level: threshold in channel units.
+ * @param hysteresis: distance back from level that re-arms the rule.
+ * @param callback: called when the rule fires (may be 0, the flag is set anyway).
+ * @retval Rule index, -1 if the table is full or the arguments are invalid
+ * @note The first sample only sets the state, a rule fires on crossings
+ */
+int8_t bmp_event::addThreshold(uint8_t channel, uint8_t type, int32_t level, uint32_t hysteresis,
+                               bmp_event_callback callback, void* context){
+    if(type != BMP_EVENT_ABOVE && type != BMP_EVENT_BELOW) return -1;
+    rule_t rule = {channel, type, 1, 0, 0, level, hysteresis, callback, context};
+    return this->add(rule);
+}
+
+
+/**
+ * @brief Add delta rule
+ * @param delta: change from the value at the last event that fires the rule (> 0).
+ * @retval Rule index, -1 if the table is full or the arguments are invalid
+ * @note The reference is the value at the last event, so slow drift fires as well
+ */
+int8_t bmp_event::addDelta(uint8_t channel, uint32_t delta, bmp_event_callback callback, void* context){
+    if(!delta) return -1;
+    rule_t rule = {channel, BMP_EVENT_DELTA, 1, 0, 0, 0, delta, callback, context};
+    return this->add(rule);
+}
+
+
+/**
+ * @brief Enable or disable rule, enabling restarts it from the next sample
+ */
+void bmp_event::setEnabled(uint8_t rule, uint8_t enabled){
+    if(rule >= this->count) return;
+    this->rules[rule].enabled = enabled;
+    this->rules[rule].primed = 0;
+}
+
+
+/**
+ * @brief Remove all rules and pending flags
+ */
+void bmp_event::clear(){
+    this->count = 0;
+    this->flags.store(0);
+}
+
+
+/**
+ * @brief Keep rules, forget their state and pending flags
+ */
+void bmp_event::reset(){
+    for(uint8_t i = 0; i < this->count; i++) this->rules[i].primed = 0;
+    this->flags.store(0);
+}
+
+
+/**
+ * @brief Check sample against all rules
+ * @retval Mask of the rules that fired on this sample
+ */
+uint32_t bmp_event::process(const bmp_sample* sample){
+    uint32_t fired = 0;
+    for(uint8_t i = 0; i < this->count; i++){
+        rule_t& rule = this->rules[i];
+        if(!rule.enabled) continue;
+        int32_t value = channelValue(rule.channel, sample);
+
+        if(rule.type == BMP_EVENT_DELTA){
+            if(!rule.primed){
+                rule.level = value;
+                rule.primed = 1;
+                continue;
+            }
+            int64_t change = (int64_t)value - rule.level;
+            if(change < 0) change = -change;
+            if(change < rule.margin) continue;
+            rule.level = value;
+            fired |= 1UL << i;
+            continue;
+        }
+
+        uint8_t above = rule.type == BMP_EVENT_ABOVE;
+        uint8_t reached = above ? (value >= rule.level) : (value <= rule.level);
+        uint8_t released = above ? ((int64_t)value < (int64_t)rule.level - rule.margin)
+                                 : ((int64_t)value > (int64_t)rule.level + rule.margin);
+        if(!rule.primed){
+            rule.active = reached;
+            rule.primed = 1;
+            continue;
+        }
+        if(rule.active){
+            if(released) rule.active = 0;
+        }
+        else if(reached){
+            rule.active = 1;
+            fired |= 1UL << i;
+        }
+    }
+
+    if(fired){
+        this->flags.fetch_or(fired);
+        for(uint8_t i = 0; i < this->count; i++){
+            if((fired & (1UL << i)) && this->rules[i].callback) this->rules[i].callback(i, sample, this->rules[i].context);
+        }
+    }
+    return fired;
+}
+
+
+/**
+ * @brief Mask of rules fired since the last take()
+ */
+uint32_t bmp_event::pending() const{
+    return this->flags.load();
+}
+
+
+/**
+ * @brief Read and clear the pending mask atomically (safe against process() in an ISR)
+ */
+uint32_t bmp_event::take(){
+    return this->flags.exchange(0);
+}
+
+
+/**
+ * @brief Threshold rule condition holds (level reached and not yet released)
+ */
+uint8_t bmp_event::active(uint8_t rule) const{
+    if(rule >= this->count) return 0;
+    return this->rules[rule].active;
+}
+
+
+/**
+ * @brief Append rule to the table
+ */
+int8_t bmp_event::add(const rule_t& rule){
+    if(this->count >= BMP_EVENT_MAX_RULES || rule.channel > BMP_EVENT_HUMIDITY) return -1;
+    this->rules[this->count] = rule;
+    return (int8_t)this->count++;
+}
+
+
+/**
+ * @brief Value of a channel in sample units
+ */
+int32_t bmp_event::channelValue(uint8_t channel, const bmp_sample* sample){
+    if(channel == BMP_EVENT_TEMPERATURE) return sample->temperature;
+    if(channel == BMP_EVENT_PRESSURE) return (int32_t)sample->pressure;
+    return (int32_t)sample->humidity;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file bmp_event.h
+ * @author Denys Khmil
+ * @brief This file contents the threshold/delta event detector of compensated samples
+ */
+#ifndef BMP_EVENT
+#define BMP_EVENT
+
+#include <stdint.h>
+#include <atomic>
+#include "bmp_sample.h"
+
+/*CHANNELS*/
+#define BMP_EVENT_TEMPERATURE   0
+#define BMP_EVENT_PRESSURE      1
+#define BMP_EVENT_HUMIDITY      2
+
+/*RULE TYPES*/
+#define BMP_EVENT_ABOVE         0
+#define BMP_EVENT_BELOW         1
+#define BMP_EVENT_DELTA         2
+
+#define BMP_EVENT_MAX_RULES     8
+
+/**
+ * @brief Event callback, called in the context of process()
+ * @param rule: index of the rule that fired.
+ */
+typedef void (*bmp_event_callback)(uint8_t rule, const bmp_sample* sample, void* context);
+
+/**
+ * @brief Fires callbacks/flags only when a channel crosses a level or changes by a delta
+ * @note Levels and deltas keep the units of the channel (e.g. Q24.8 Pa for pressure).
+ *       process() costs O(BMP_EVENT_MAX_RULES) and never blocks, so it may run in the
+ *       acquisition context (ISR or task); consumers sleep until pending() is non-zero
+ */
+class bmp_event{
+public:
+    /*CONSTRUCTORS*/
+    bmp_event();
+
+    /*RULES*/
+    int8_t addThreshold(uint8_t channel, uint8_t type, int32_t level, uint32_t hysteresis,
+                        bmp_event_callback callback = 0, void* context = 0);
+    int8_t addDelta(uint8_t channel, uint32_t delta, bmp_event_callback callback = 0, void* context = 0);
+    void setEnabled(uint8_t rule, uint8_t enabled);
+    void clear();
+    void reset();
+
+    /*UPDATE*/
+    uint32_t process(const bmp_sample* sample);
+
+    /*QUERIES*/
+    uint32_t pending() const;
+    uint32_t take();
+    uint8_t active(uint8_t rule) const;
+
+private:
+    struct rule_t{
+        uint8_t channel;
+        uint8_t type;
+        uint8_t enabled;
+        uint8_t primed;
+        uint8_t active;
+        int32_t level;
+        uint32_t margin;
+        bmp_event_callback callback;
+        void* context;
+    };
+
+    int8_t add(const rule_t& rule);
+    static int32_t channelValue(uint8_t channel, const bmp_sample* sample);
+
+    rule_t rules[BMP_EVENT_MAX_RULES];
+    uint8_t count;
+    std::atomic<uint32_t> flags;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ * @file bmp_fanout.cpp
+ * @author Denys Khmil
+ * @brief This file contents the multi-rate fan-out functions
+ */
+#include "bmp_fanout.h"
+
+/**
+ * @brief Fan-out without subscribers
+ */
+bmp_fanout::bmp_fanout(){
+    this->subscriberCount = 0;
+}
+
+
+/**
+ * @brief Add subscriber
+ * @param ratio: input samples per output sample (1 = every sample).
+ * @param mode: BMP_FANOUT_DECIMATE or BMP_FANOUT_AVERAGE.
+ * @param sink: called with every output sample.
+ * @retval Subscriber index, -1 if the table is full or the arguments are invalid
+ */
+int8_t bmp_fanout::subscribe(uint16_t ratio, uint8_t mode, bmp_fanout_sink sink, void* context){
+    if(this->subscriberCount >= BMP_FANOUT_MAX_SUBSCRIBERS || !sink) return -1;
+    if(mode != BMP_FANOUT_DECIMATE && mode != BMP_FANOUT_AVERAGE) return -1;
+    subscriber_t& subscriber = this->subscribers[this->subscriberCount];
+    subscriber.sink = sink;
+    subscriber.context = context;
+    subscriber.ratio = ratio ? ratio : 1;
+    subscriber.mode = mode;
+    subscriber.delivered = 0;
+    restart(subscriber);
+    return (int8_t)this->subscriberCount++;
+}
+
+
+/**
+ * @brief Change output ratio, the running average restarts
+ */
+void bmp_fanout::setRatio(uint8_t subscriber, uint16_t ratio){
+    if(subscriber >= this->subscriberCount) return;
+    this->subscribers[subscriber].ratio = ratio ? ratio : 1;
+    restart(this->subscribers[subscriber]);
+}
+
+
+/**
+ * @brief Remove all subscribers
+ */
+void bmp_fanout::clear(){
+    this->subscriberCount = 0;
+}
+
+
+/**
+ * @brief Keep subscribers, drop partial averages
+ */
+void bmp_fanout::reset(){
+    for(uint8_t i = 0; i < this->subscriberCount; i++) restart(this->subscribers[i]);
+}
+
+
+/**
+ * @brief Feed one compensated sample to all subscribers
+ */
+void bmp_fanout::process(const bmp_sample* sample){
+    for(uint8_t i = 0; i < this->subscriberCount; i++){
+        subscriber_t& subscriber = this->subscribers[i];
+        if(subscriber.mode == BMP_FANOUT_AVERAGE){
+            subscriber.temperature += sample->temperature;
+            subscriber.pressure += sample->pressure;
+            subscriber.humidity += sample->humidity;
+        }
+        if(++subscriber.count < subscriber.ratio) continue;
+
+        if(subscriber.mode == BMP_FANOUT_AVERAGE){
+            bmp_sample mean;
+            mean.temperature = (int32_t)roundedMean(subscriber.temperature, subscriber.count);
+            mean.pressure = (uint32_t)roundedMean(subscriber.pressure, subscriber.count);
+            mean.humidity = (uint32_t)roundedMean(subscriber.humidity, subscriber.count);
+            restart(subscriber);
+            subscriber.sink(&mean, subscriber.context);
+        }
+        else{
+            restart(subscriber);
+            subscriber.sink(sample, subscriber.context);
+        }
+        subscriber.delivered++;
+    }
+}
+
+
+/**
+ * @brief Number of subscribers
+ */
+uint8_t bmp_fanout::count() const{
+    return this->subscriberCount;
+}
+
+
+/**
+ * @brief Output samples delivered to subscriber
+ */
+uint32_t bmp_fanout::delivered(uint8_t subscriber) const{
+    return (subscriber < this->subscriberCount) ? this->subscribers[subscriber].delivered : 0;
+}
+
+
+/**
+ * @brief Start a new output period
+ */
+void bmp_fanout::restart(subscriber_t& subscriber){
+    subscriber.count = 0;
+    subscriber.temperature = 0;
+    subscriber.pressure = 0;
+    subscriber.humidity = 0;
+}
+
+
+/**
+ * @brief Mean rounded half away from zero
+ */
+int64_t bmp_fanout::roundedMean(int64_t sum, uint16_t count){
+    return (sum >= 0) ? (sum + count / 2) / count : (sum - count / 2) / count;
+}
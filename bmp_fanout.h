@@ -0,0 +1,78 @@
+/**
+ * @file bmp_fanout.h
+ * @author Denys Khmil
+ * @brief This file contents the multi-rate fan-out of one sample stream
+ */
+#ifndef BMP_FANOUT
+#define BMP_FANOUT
+
+#include <stdint.h>
+#include "bmp_sample.h"
+
+/*SUBSCRIBER MODES*/
+#define BMP_FANOUT_DECIMATE         0
+#define BMP_FANOUT_AVERAGE          1
+
+#define BMP_FANOUT_MAX_SUBSCRIBERS  8
+
+/**
+ * @brief Subscriber sink, called in the context of process()
+ */
+typedef void (*bmp_fanout_sink)(const bmp_sample* sample, void* context);
+
+/**
+ * @brief Fans one acquisition stream out to subscribers with their own output ratio
+ * @note Each sample is read and compensated once by the caller, then every subscriber
+ *       either passes each ratio-th sample (BMP_FANOUT_DECIMATE) or the rounded mean of
+ *       ratio samples (BMP_FANOUT_AVERAGE, a boxcar anti-alias filter). Sums are updated
+ *       incrementally, so process() costs O(subscribers) and no sample history is kept.
+ *       E.g. at 50 Hz input: controller ratio 1, telemetry ratio 5, logger ratio 50
+ */
+class bmp_fanout{
+public:
+    /*CONSTRUCTORS*/
+    bmp_fanout();
+
+    /*SUBSCRIBERS*/
+    int8_t subscribe(uint16_t ratio, uint8_t mode, bmp_fanout_sink sink, void* context = 0);
+    void setRatio(uint8_t subscriber, uint16_t ratio);
+    void clear();
+    void reset();
+
+    /*UPDATE*/
+    void process(const bmp_sample* sample);
+
+    /**
+     * @brief Pipeline stage form (see bmp_pipeline), the input is passed on unchanged
+     */
+    template<typename Next>
+    void process(const bmp_sample& sample, Next& next){
+        this->process(&sample);
+        next.push(sample);
+    }
+
+    /*QUERIES*/
+    uint8_t count() const;
+    uint32_t delivered(uint8_t subscriber) const;
+
+private:
+    struct subscriber_t{
+        bmp_fanout_sink sink;
+        void* context;
+        uint16_t ratio;
+        uint16_t count;
+        uint8_t mode;
+        int64_t temperature;
+        int64_t pressure;
+        int64_t humidity;
+        uint32_t delivered;
+    };
+
+    static void restart(subscriber_t& subscriber);
+    static int64_t roundedMean(int64_t sum, uint16_t count);
+
+    subscriber_t subscribers[BMP_FANOUT_MAX_SUBSCRIBERS];
+    uint8_t subscriberCount;
+};
+
+#endif
@@ -0,0 +1,172 @@
+/**
+ * @file bmp_filter.h
+ * @author Denys Khmil
+ * @brief This file contents the fixed-point biquad filters for compensated samples
+ */
+#ifndef BMP_FILTER
+#define BMP_FILTER
+
+#include <stdint.h>
+
+/*COEFFICIENT FORMAT*/
+#define BMP_BIQUAD_SHIFT 29
+
+namespace bmp_filter_detail{
+
+constexpr double pi = 3.14159265358979323846;
+
+/**
+ * @brief Taylor series sine for compile-time coefficient design, |x| <= pi
+ */
+constexpr double sin(double x){
+    double term = x;
+    double sum = x;
+    for(int n = 1; n < 16; n++){
+        term = -term * x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * @brief Taylor series cosine for compile-time coefficient design, |x| <= pi
+ */
+constexpr double cos(double x){
+    double term = 1.0;
+    double sum = 1.0;
+    for(int n = 1; n < 16; n++){
+        term = -term * x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * @brief Round to Q(BMP_BIQUAD_SHIFT) coefficient
+ */
+constexpr int32_t toFixed(double value){
+    return (int32_t)(value * (double)(1L << BMP_BIQUAD_SHIFT) + (value >= 0 ? 0.5 : -0.5));
+}
+
+}
+
+/**
+ * @brief Second order low-pass coefficients designed at compile time
+ * @param CutoffMilliHz: -3 dB frequency in mHz (below SampleMilliHz/2).
+ * @param SampleMilliHz: sample rate in mHz.
+ * @param QMilli: quality factor * 1000 (707 = Butterworth).
+ * @note Coefficients are Q2.29, a1/a2 are quantized first and b0..b2 are derived from
+ *       them so that the DC gain is exactly 1 in integer arithmetic
+ */
+template<uint32_t CutoffMilliHz, uint32_t SampleMilliHz, uint32_t QMilli = 707>
+struct bmp_lowpass{
+    static_assert(2 * (uint64_t)CutoffMilliHz < SampleMilliHz, "cutoff must be below Nyquist");
+
+    static constexpr double w0 = 2.0 * bmp_filter_detail::pi * CutoffMilliHz / SampleMilliHz;
+    static constexpr double alpha = bmp_filter_detail::sin(w0) * 500.0 / QMilli;
+    static constexpr double a0 = 1.0 + alpha;
+
+    static constexpr int32_t a1 = bmp_filter_detail::toFixed(-2.0 * bmp_filter_detail::cos(w0) / a0);
+    static constexpr int32_t a2 = bmp_filter_detail::toFixed((1.0 - alpha) / a0);
+    static constexpr int32_t b0 = (int32_t)((((int64_t)1 << BMP_BIQUAD_SHIFT) + a1 + a2) / 4);
+    static constexpr int32_t b1 = (int32_t)((((int64_t)1 << BMP_BIQUAD_SHIFT) + a1 + a2) / 2);
+    static constexpr int32_t b2 = (int32_t)((((int64_t)1 << BMP_BIQUAD_SHIFT) + a1 + a2) - b0 - b1);
+};
+
+/**
+ * @brief Direct form I biquad section with error feedback
+ * @param Coefficients: coefficient type with static b0, b1, b2, a1, a2 (e.g. bmp_lowpass).
+ * @note Input and output are int32 (e.g. bmp_sample::pressure in Q24.8), accumulation is int64.
+ *       The first sample primes the state, so there is no start-up transient from zero
+ */
+template<typename Coefficients>
+class bmp_biquad{
+public:
+    bmp_biquad(){
+        this->primed = 0;
+        this->reset(0);
+    }
+
+    /**
+     * @brief Set steady state to value
+     */
+    void reset(int32_t value){
+        this->x1 = value;
+        this->x2 = value;
+        this->y1 = value;
+        this->y2 = value;
+        this->error = 0;
+    }
+
+    /**
+     * @brief Filter one sample
+     * @retval Filtered sample
+     */
+    int32_t process(int32_t x){
+        if(!this->primed){
+            this->reset(x);
+            this->primed = 1;
+        }
+        int64_t acc = (int64_t)Coefficients::b0 * x
+                    + (int64_t)Coefficients::b1 * this->x1
+                    + (int64_t)Coefficients::b2 * this->x2
+                    - (int64_t)Coefficients::a1 * this->y1
+                    - (int64_t)Coefficients::a2 * this->y2
+                    + this->error;
+        int32_t y = (int32_t)(acc >> BMP_BIQUAD_SHIFT);
+        this->error = (int32_t)(acc - ((int64_t)y << BMP_BIQUAD_SHIFT));
+        this->x2 = this->x1;
+        this->x1 = x;
+        this->y2 = this->y1;
+        this->y1 = y;
+        return y;
+    }
+
+private:
+    int32_t x1;
+    int32_t x2;
+    int32_t y1;
+    int32_t y2;
+    int32_t error;
+    uint8_t primed;
+};
+
+/**
+ * @brief Cascade of filter sections processed in order
+ * @note Sections are any types with process(int32_t) and reset(int32_t), calls are inlined
+ */
+template<typename... Sections>
+class bmp_cascade;
+
+template<>
+class bmp_cascade<>{
+public:
+    int32_t process(int32_t x){ return x; }
+    void reset(int32_t){}
+};
+
+template<typename First, typename... Rest>
+class bmp_cascade<First, Rest...>{
+public:
+    int32_t process(int32_t x){
+        return this->rest.process(this->first.process(x));
+    }
+
+    void reset(int32_t value){
+        this->first.reset(value);
+        this->rest.reset(value);
+    }
+
+private:
+    First first;
+    bmp_cascade<Rest...> rest;
+};
+
+/**
+ * @brief 4th order Butterworth low-pass (two sections, Q = 0.541 and 1.307)
+ */
+template<uint32_t CutoffMilliHz, uint32_t SampleMilliHz>
+using bmp_butterworth4 = bmp_cascade<bmp_biquad<bmp_lowpass<CutoffMilliHz, SampleMilliHz, 541> >,
+                                     bmp_biquad<bmp_lowpass<CutoffMilliHz, SampleMilliHz, 1307> > >;
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file bmp_history.cpp
+ * @author Denys Khmil
+ * @brief This file contents the multi-resolution pressure history functions
+ */
+#include "bmp_history.h"
+
+static const uint32_t historyDuration[BMP_HISTORY_LEVELS] = {1, 60, 600, 3600};
+static const uint16_t historyLength[BMP_HISTORY_LEVELS] = {BMP_HISTORY_SECOND_BUCKETS, BMP_HISTORY_MINUTE_BUCKETS,
+                                                           BMP_HISTORY_10MIN_BUCKETS, BMP_HISTORY_HOUR_BUCKETS};
+static const uint16_t historyOffset[BMP_HISTORY_LEVELS] = {0, BMP_HISTORY_SECOND_BUCKETS,
+                                                           BMP_HISTORY_SECOND_BUCKETS + BMP_HISTORY_MINUTE_BUCKETS,
+                                                           BMP_HISTORY_BUCKETS - BMP_HISTORY_HOUR_BUCKETS};
+
+/**
+ * @brief Empty history
+ */
+bmp_history::bmp_history(){
+    this->reset();
+}
+
+
+/**
+ * @brief Forget all buckets
+ */
+void bmp_history::reset(){
+    for(uint8_t level = 0; level < BMP_HISTORY_LEVELS; level++){
+        this->current[level].open = 0;
+        this->head[level] = 0;
+        this->filled[level] = 0;
+    }
+}
+
+
+/**
+ * @brief Add sample
+ * @param time_s: sample time in seconds (non-decreasing, e.g. RTC or HAL_GetTick() / 1000).
+ */
+void bmp_history::add(uint32_t time_s, const bmp_sample* sample){
+    this->fold(0, time_s, sample->pressure, 1, sample->pressure, sample->pressure);
+}
+
+
+/**
+ * @brief Decoded bucket
+ * @param level: 0 = 1 s .. 3 = 1 h.
+ * @param age: 0 = newest finished bucket.
+ * @retval 1 if the bucket exists and holds samples
+ */
+uint8_t bmp_history::bucket(uint8_t level, uint16_t age, bmp_history_bucket* result) const{
+    if(level >= BMP_HISTORY_LEVELS || age >= this->filled[level]) return 0;
+    const uint16_t* entry = this->buckets[this->slot(level, age)];
+    if(entry[2] == BMP_HISTORY_MISSING) return 0;
+    result->min = decode(entry[0]);
+    result->max = decode(entry[1]);
+    result->mean = decode(entry[2]);
+    return 1;
+}
+
+
+/**
+ * @brief Pressure change over span
+ * @param span_s: e.g. 3 * 3600 or 24 * 3600.
+ * @param delta: newest mean minus the mean span_s earlier, Q24.8 Pa.
+ * @retval 1 if both buckets are stored
+ * @note Uses the finest level that still holds span_s, rounded to its bucket length
+ */
+uint8_t bmp_history::tendency(uint32_t span_s, int32_t* delta) const{
+    for(uint8_t level = 0; level < BMP_HISTORY_LEVELS; level++){
+        uint32_t age = (span_s + historyDuration[level] / 2) / historyDuration[level];
+        if(!age || age >= historyLength[level]) continue;
+        bmp_history_bucket now;
+        bmp_history_bucket then;
+        if(!this->bucket(level, 0, &now) || !this->bucket(level, (uint16_t)age, &then)) return 0;
+        *delta = (int32_t)(now.mean - then.mean);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Bucket length of level in s
+ */
+uint32_t bmp_history::duration(uint8_t level) const{
+    return (level < BMP_HISTORY_LEVELS) ? historyDuration[level] : 0;
+}
+
+
+/**
+ * @brief Number of buckets of level
+ */
+uint16_t bmp_history::length(uint8_t level) const{
+    return (level < BMP_HISTORY_LEVELS) ? historyLength[level] : 0;
+}
+
+
+/**
+ * @brief Add samples to the bucket of level that holds time_s
+ * @note A new bucket id closes the open bucket and records the skipped ones as missing
+ */
+void bmp_history::fold(uint8_t level, uint32_t time_s, int64_t sum, uint32_t count, uint32_t min, uint32_t max){
+    accumulator_t& acc = this->current[level];
+    uint32_t id = time_s / historyDuration[level];
+    if(acc.open && id != acc.id){
+        uint32_t gap = id - acc.id - 1;
+        this->close(level);
+        if(gap > historyLength[level]) gap = historyLength[level];
+        while(gap--) this->store(level, BMP_HISTORY_MISSING, BMP_HISTORY_MISSING, BMP_HISTORY_MISSING);
+    }
+    if(!acc.open || id != acc.id){
+        acc.id = id;
+        acc.open = 1;
+        acc.sum = 0;
+        acc.count = 0;
+        acc.min = min;
+        acc.max = max;
+    }
+    acc.sum += sum;
+    acc.count += count;
+    if(min < acc.min) acc.min = min;
+    if(max > acc.max) acc.max = max;
+}
+
+
+/**
+ * @brief Store open bucket of level and fold it into the next level
+ */
+void bmp_history::close(uint8_t level){
+    accumulator_t& acc = this->current[level];
+    acc.open = 0;
+    int64_t mean = (acc.sum + acc.count / 2) / acc.count;
+    this->store(level, encode(acc.min), encode(acc.max), encode(mean));
+    if(level + 1 < BMP_HISTORY_LEVELS){
+        this->fold(level + 1, acc.id * historyDuration[level], acc.sum, acc.count, acc.min, acc.max);
+    }
+}
+
+
+/**
+ * @brief Append bucket to the ring of level
+ */
+void bmp_history::store(uint8_t level, uint16_t min, uint16_t max, uint16_t mean){
+    this->head[level] = (uint16_t)((this->head[level] + 1) % historyLength[level]);
+    if(this->filled[level] < historyLength[level]) this->filled[level]++;
+    uint16_t* entry = this->buckets[this->slot(level, 0)];
+    entry[0] = min;
+    entry[1] = max;
+    entry[2] = mean;
+}
+
+
+/**
+ * @brief Bucket index of level by age (0 = newest)
+ */
+uint16_t bmp_history::slot(uint8_t level, uint16_t age) const{
+    return historyOffset[level] + (uint16_t)((this->head[level] + historyLength[level] - age) % historyLength[level]);
+}
+
+
+/**
+ * @brief Q24.8 Pa to 1 Pa steps from BMP_HISTORY_BASE_PA (clamped)
+ */
+uint16_t bmp_history::encode(int64_t pressure){
+    int64_t pascal = (pressure + 128) / 256 - BMP_HISTORY_BASE_PA;
+    if(pascal < 0) pascal = 0;
+    if(pascal > BMP_HISTORY_MISSING - 1) pascal = BMP_HISTORY_MISSING - 1;
+    return (uint16_t)pascal;
+}
+
+
+/**
+ * @brief 1 Pa steps to Q24.8 Pa
+ */
+uint32_t bmp_history::decode(uint16_t value){
+    return ((uint32_t)value + BMP_HISTORY_BASE_PA) * 256;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file bmp_history.h
+ * @author Denys Khmil
+ * @brief This file contents the multi-resolution pressure history (round robin store)
+ */
+#ifndef BMP_HISTORY
+#define BMP_HISTORY
+
+#include <stdint.h>
+#include "bmp_sample.h"
+
+/*LEVELS: bucket length in s and number of buckets*/
+#define BMP_HISTORY_LEVELS          4
+#define BMP_HISTORY_SECOND_BUCKETS  120
+#define BMP_HISTORY_MINUTE_BUCKETS  60
+#define BMP_HISTORY_10MIN_BUCKETS   36
+#define BMP_HISTORY_HOUR_BUCKETS    48
+#define BMP_HISTORY_BUCKETS         (BMP_HISTORY_SECOND_BUCKETS + BMP_HISTORY_MINUTE_BUCKETS + \
+                                     BMP_HISTORY_10MIN_BUCKETS + BMP_HISTORY_HOUR_BUCKETS)
+
+/*ENCODING: 1 Pa per step from BASE, MISSING marks a bucket without samples*/
+#define BMP_HISTORY_BASE_PA         40000
+#define BMP_HISTORY_MISSING         0xFFFF
+
+/**
+ * @brief Decoded bucket, pressure in Q24.8 Pa
+ */
+struct bmp_history_bucket{
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+};
+
+/**
+ * @brief Pressure min/max/mean at 1 s, 1 min, 10 min and 1 h resolution
+ * @note Buckets are aligned to multiples of their length in the caller's time base and stored
+ *       as three uint16_t (1 Pa steps from BMP_HISTORY_BASE_PA, 40000..105534 Pa): the default
+ *       sizes keep 2 min, 1 h, 6 h and 48 h in 1584 bytes. A finished bucket is folded into the
+ *       next level with its exact sum and count, so add() is O(1); a time gap writes at most
+ *       one ring length of missing buckets per level. tendency() compares two stored means
+ */
+class bmp_history{
+public:
+    /*CONSTRUCTORS*/
+    bmp_history();
+
+    /*UPDATE*/
+    void add(uint32_t time_s, const bmp_sample* sample);
+    void reset();
+
+    /*QUERIES*/
+    uint8_t bucket(uint8_t level, uint16_t age, bmp_history_bucket* result) const;
+    uint8_t tendency(uint32_t span_s, int32_t* delta) const;
+    uint32_t duration(uint8_t level) const;
+    uint16_t length(uint8_t level) const;
+
+private:
+    struct accumulator_t{
+        uint32_t id;
+        uint8_t open;
+        int64_t sum;
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+    };
+
+    void fold(uint8_t level, uint32_t time_s, int64_t sum, uint32_t count, uint32_t min, uint32_t max);
+    void close(uint8_t level);
+    void store(uint8_t level, uint16_t min, uint16_t max, uint16_t mean);
+    uint16_t slot(uint8_t level, uint16_t age) const;
+    static uint16_t encode(int64_t pressure);
+    static uint32_t decode(uint16_t value);
+
+    accumulator_t current[BMP_HISTORY_LEVELS];
+    uint16_t head[BMP_HISTORY_LEVELS];
+    uint16_t filled[BMP_HISTORY_LEVELS];
+
+    /*RINGS OF ALL LEVELS (min, max, mean per bucket)*/
+    uint16_t buckets[BMP_HISTORY_BUCKETS][3];
+};
+
+#endif
@@ -0,0 +1,294 @@
+/**
+ * @file bmp_logger.h
+ * @author Denys Khmil
+ * @brief This file contents the wear-leveled batched flash logger
+ */
+#ifndef BMP_LOGGER
+#define BMP_LOGGER
+
+#include <stdint.h>
+#include "bmp_sample.h"
+
+/*PAGE FORMAT*/
+#define BMP_LOG_MAGIC           0x4C504D42UL
+#define BMP_LOG_HEADER_SIZE     12
+#define BMP_LOG_RECORD_SIZE     12
+
+/**
+ * @brief Logged sample
+ * @note Stored little-endian in 12 bytes: time, pressure (Q24.8 Pa),
+ *       temperature (0.01 degC) and humidity (0.01 %RH)
+ */
+struct bmp_log_record{
+    uint32_t time;
+    uint32_t pressure;
+    int16_t temperature;
+    uint16_t humidity;
+};
+
+/**
+ * @brief Circular log of sample pages on NOR flash
+ * @param Flash: device with non-blocking erase/program and blocking read:
+ *        uint8_t busy(), uint8_t erase(uint32_t address), uint8_t program(uint32_t address,
+ *        const uint8_t* data, uint16_t length), uint8_t read(uint32_t address, uint8_t* data,
+ *        uint16_t length), uint32_t sectorSize(), uint32_t size(). Start functions return 1 if started.
+ * @param PageSize: program page size (a divisor of the sector size).
+ * @note Records collect in one RAM page while the other is programmed; poll() advances erase
+ *       and program without blocking. Pages are written in address order around the whole
+ *       device, a sector is erased just before its first page, so every sector wears the same
+ *       and the oldest data is overwritten first. Each page carries a sequence number and a
+ *       CRC: mount() finds the newest valid page after a power loss and skips torn pages.
+ *       add(), flush() and poll() must run in one context
+ */
+template<typename Flash, uint16_t PageSize = 256>
+class bmp_logger{
+    static_assert(PageSize > BMP_LOG_HEADER_SIZE + BMP_LOG_RECORD_SIZE, "page too small");
+public:
+    static const uint16_t RecordsPerPage = (PageSize - BMP_LOG_HEADER_SIZE) / BMP_LOG_RECORD_SIZE;
+
+    /*CONSTRUCTORS*/
+    bmp_logger(Flash* _flash){
+        this->flash = _flash;
+        this->pageCount = _flash->size() / PageSize;
+        this->pagesPerSector = _flash->sectorSize() / PageSize;
+        this->nextPage = 0;
+        this->sequence = 0;
+        this->erased = 0;
+        this->fill = 0;
+        this->fillCount = 0;
+        this->pending = 0;
+        this->state = idle;
+        this->dropCount = 0;
+        this->writeCount = 0;
+        this->eraseCount = 0;
+    }
+
+    /**
+     * @brief Find the write position after reset or power loss
+     * @retval Number of valid pages found
+     * @note Blocking scan of all pages, call once before logging
+     */
+    uint32_t mount(){
+        uint32_t newest = 0;
+        uint32_t valid = 0;
+        uint8_t found = 0;
+        for(uint32_t page = 0; page < this->pageCount; page++){
+            uint32_t page_sequence;
+            if(!this->readPage(page, 0, 0, &page_sequence)) continue;
+            valid++;
+            if(!found || (int32_t)(page_sequence - this->sequence) > 0){
+                this->sequence = page_sequence;
+                newest = page;
+                found = 1;
+            }
+        }
+        if(!found){
+            this->sequence = 0;
+            this->nextPage = 0;
+            this->erased = 0;
+            return 0;
+        }
+
+        /*continue after the newest page, skipping torn pages up to the next sector*/
+        this->sequence++;
+        this->nextPage = (newest + 1) % this->pageCount;
+        this->erased = 1;
+        while(this->nextPage % this->pagesPerSector){
+            if(this->blank(this->nextPage)) break;
+            this->nextPage = (this->nextPage + 1) % this->pageCount;
+        }
+        if(!(this->nextPage % this->pagesPerSector)) this->erased = 0;
+        return valid;
+    }
+
+    /**
+     * @brief Add sample to the RAM page
+     * @param time: caller's timestamp (e.g. HAL_GetTick()).
+     * @retval 1 if stored, 0 if both RAM pages are full (counted in dropped())
+     */
+    uint8_t add(uint32_t time, const bmp_sample* sample){
+        if(this->fillCount == RecordsPerPage && !this->handOff()){
+            this->dropCount++;
+            return 0;
+        }
+        uint8_t* record = &this->buffers[this->fill][BMP_LOG_HEADER_SIZE + this->fillCount * BMP_LOG_RECORD_SIZE];
+        int32_t temperature = sample->temperature;
+        if(temperature > INT16_MAX) temperature = INT16_MAX;
+        if(temperature < INT16_MIN) temperature = INT16_MIN;
+        uint32_t humidity = (uint32_t)(((uint64_t)sample->humidity * 100 + 512) >> 10);
+        put32(record, time);
+        put32(record + 4, sample->pressure);
+        put16(record + 8, (uint16_t)temperature);
+        put16(record + 10, (uint16_t)((humidity > UINT16_MAX) ? UINT16_MAX : humidity));
+        this->fillCount++;
+        if(this->fillCount == RecordsPerPage) this->handOff();
+        return 1;
+    }
+
+    /**
+     * @brief Queue the partial RAM page for writing (e.g. before sleep or shutdown)
+     * @retval 1 if queued or empty, 0 if the previous page is still being written
+     */
+    uint8_t flush(){
+        if(!this->fillCount) return 1;
+        return this->handOff();
+    }
+
+    /**
+     * @brief Advance erase/program of the pending page, never blocks
+     * @retval 1 while work is pending
+     */
+    uint8_t poll(){
+        if(this->state != idle && this->flash->busy()) return 1;
+        if(this->state == programming){
+            this->writeCount++;
+            this->nextPage = (this->nextPage + 1) % this->pageCount;
+            this->erased = (this->nextPage % this->pagesPerSector) != 0;
+            this->pending = 0;
+            this->state = idle;
+            if(this->fillCount == RecordsPerPage) this->handOff();
+        }
+        else if(this->state == erasing){
+            this->eraseCount++;
+            this->erased = 1;
+            this->state = idle;
+        }
+        if(!this->pending) return 0;
+
+        if(!this->erased){
+            if(this->flash->erase((this->nextPage / this->pagesPerSector) * this->flash->sectorSize())) this->state = erasing;
+            return 1;
+        }
+        uint8_t* page = this->buffers[this->fill ^ 1];
+        if(this->flash->program(this->nextPage * PageSize, page, PageSize)) this->state = programming;
+        return 1;
+    }
+
+    /**
+     * @brief Read stored page
+     * @param page: physical page index.
+     * @param records: destination for up to RecordsPerPage records (0 to only validate).
+     * @param count: number of records (may be 0).
+     * @param page_sequence: sequence number of the page (may be 0).
+     * @retval 1 if the page is valid
+     */
+    uint8_t readPage(uint32_t page, bmp_log_record* records, uint16_t* count, uint32_t* page_sequence){
+        uint8_t buffer[PageSize];
+        if(page >= this->pageCount || !this->flash->read(page * PageSize, buffer, PageSize)) return 0;
+        if(get32(buffer) != BMP_LOG_MAGIC) return 0;
+        uint16_t records_in_page = get16(buffer + 8);
+        if(records_in_page > RecordsPerPage) return 0;
+        if(get16(buffer + 10) != crc(buffer, records_in_page)) return 0;
+        if(count) *count = records_in_page;
+        if(page_sequence) *page_sequence = get32(buffer + 4);
+        for(uint16_t i = 0; records && i < records_in_page; i++){
+            const uint8_t* record = &buffer[BMP_LOG_HEADER_SIZE + i * BMP_LOG_RECORD_SIZE];
+            records[i].time = get32(record);
+            records[i].pressure = get32(record + 4);
+            records[i].temperature = (int16_t)get16(record + 8);
+            records[i].humidity = get16(record + 10);
+        }
+        return 1;
+    }
+
+    /*STATE*/
+    uint32_t writePosition() const{ return this->nextPage; }
+    uint32_t nextSequence() const{ return this->sequence; }
+    uint32_t pages() const{ return this->pageCount; }
+
+    /*COUNTERS*/
+    uint32_t dropped() const{ return this->dropCount; }
+    uint32_t written() const{ return this->writeCount; }
+    uint32_t erases() const{ return this->eraseCount; }
+
+private:
+    enum state_t{ idle, erasing, programming };
+
+    /**
+     * @brief Seal the fill page and swap buffers if the write slot is free
+     */
+    uint8_t handOff(){
+        if(this->pending) return 0;
+        uint8_t* page = this->buffers[this->fill];
+        for(uint16_t i = BMP_LOG_HEADER_SIZE + this->fillCount * BMP_LOG_RECORD_SIZE; i < PageSize; i++) page[i] = 0xFF;
+        put32(page, BMP_LOG_MAGIC);
+        put32(page + 4, this->sequence++);
+        put16(page + 8, this->fillCount);
+        put16(page + 10, crc(page, this->fillCount));
+        this->pending = 1;
+        this->fill ^= 1;
+        this->fillCount = 0;
+        return 1;
+    }
+
+    /**
+     * @brief Page fully erased
+     * @note Checks every byte: a program cut by power loss may leave the header erased and
+     *       records already written, programming over that page would corrupt it
+     */
+    uint8_t blank(uint32_t page){
+        uint8_t buffer[PageSize];
+        if(!this->flash->read(page * PageSize, buffer, PageSize)) return 0;
+        for(uint16_t i = 0; i < PageSize; i++){
+            if(buffer[i] != 0xFF) return 0;
+        }
+        return 1;
+    }
+
+    /**
+     * @brief CRC-16/CCITT of sequence, count and records
+     */
+    static uint16_t crc(const uint8_t* page, uint16_t records){
+        uint16_t value = crcUpdate(0xFFFF, page + 4, 6);
+        return crcUpdate(value, page + BMP_LOG_HEADER_SIZE, records * BMP_LOG_RECORD_SIZE);
+    }
+
+    static uint16_t crcUpdate(uint16_t value, const uint8_t* data, uint16_t length){
+        while(length--){
+            value ^= (uint16_t)(*data++ << 8);
+            for(uint8_t bit = 0; bit < 8; bit++) value = (value & 0x8000) ? (uint16_t)((value << 1) ^ 0x1021) : (uint16_t)(value << 1);
+        }
+        return value;
+    }
+
+    static void put16(uint8_t* data, uint16_t value){
+        data[0] = (uint8_t)value;
+        data[1] = (uint8_t)(value >> 8);
+    }
+
+    static void put32(uint8_t* data, uint32_t value){
+        put16(data, (uint16_t)value);
+        put16(data + 2, (uint16_t)(value >> 16));
+    }
+
+    static uint16_t get16(const uint8_t* data){
+        return (uint16_t)(data[0]|(data[1] << 8));
+    }
+
+    static uint32_t get32(const uint8_t* data){
+        return get16(data)|((uint32_t)get16(data + 2) << 16);
+    }
+
+    Flash* flash;
+    uint32_t pageCount;
+    uint32_t pagesPerSector;
+
+    /*WRITE POSITION*/
+    uint32_t nextPage;
+    uint32_t sequence;
+    uint8_t erased;
+
+    /*RAM PAGES*/
+    uint8_t buffers[2][PageSize];
+    uint8_t fill;
+    uint16_t fillCount;
+    uint8_t pending;
+    state_t state;
+
+    /*COUNTERS*/
+    uint32_t dropCount;
+    uint32_t writeCount;
+    uint32_t eraseCount;
+};
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * @file bmp_median.h
+ * @author Denys Khmil
+ * @brief This file contents the streaming median and Hampel outlier filters
+ */
+#ifndef BMP_MEDIAN
+#define BMP_MEDIAN
+
+#include <stdint.h>
+
+/**
+ * @brief Sliding window median in O(log N) per sample
+ * @param N: window size (odd sizes give a true median, even sizes the mean of the middle pair).
+ * @note Double heap over one index array: max-heap of the lower half at negative indices,
+ *       min-heap of the upper half at positive indices, the median at index 0.
+ *       Each sample replaces the oldest one in place and is sifted up or down, no allocation
+ */
+template<uint16_t N>
+class bmp_median{
+    static_assert(N >= 1, "window must not be empty");
+public:
+    bmp_median(){
+        this->reset();
+    }
+
+    /**
+     * @brief Forget all samples
+     */
+    void reset(){
+        this->index = 0;
+        this->count = 0;
+        this->heap = &this->heapStorage[N / 2];
+        for(int16_t i = N - 1; i >= 0; i--){
+            this->data[i] = 0;
+            this->pos[i] = (int16_t)(((i + 1) / 2) * ((i & 1) ? -1 : 1));
+            this->heap[this->pos[i]] = i;
+        }
+    }
+
+    /**
+     * @brief Add sample, replacing the oldest one when the window is full
+     */
+    void insert(int32_t value){
+        uint8_t is_new = this->count < N;
+        int16_t p = this->pos[this->index];
+        int32_t old = this->data[this->index];
+        this->data[this->index] = value;
+        this->index = (this->index + 1) % N;
+        this->count += is_new;
+
+        if(p > 0){
+            if(!is_new && old < value) this->minSortDown(p * 2);
+            else if(this->minSortUp(p)) this->maxSortDown(-1);
+        }
+        else if(p < 0){
+            if(!is_new && value < old) this->maxSortDown(p * 2);
+            else if(this->maxSortUp(p)) this->minSortDown(1);
+        }
+        else{
+            if(this->maxCount()) this->maxSortDown(-1);
+            if(this->minCount()) this->minSortDown(1);
+        }
+    }
+
+    /**
+     * @brief Median of the samples in the window
+     */
+    int32_t median() const{
+        int32_t value = this->data[this->heap[0]];
+        if((this->count & 1) == 0 && this->count){
+            value = (int32_t)(((int64_t)value + this->data[this->heap[-1]]) / 2);
+        }
+        return value;
+    }
+
+    /**
+     * @brief Add sample and return the window median
+     */
+    int32_t process(int32_t value){
+        this->insert(value);
+        return this->median();
+    }
+
+    /**
+     * @brief Number of samples in the window
+     */
+    uint16_t size() const{
+        return this->count;
+    }
+
+private:
+    uint8_t less(int16_t i, int16_t j) const{
+        return this->data[this->heap[i]] < this->data[this->heap[j]];
+    }
+
+    uint8_t exchange(int16_t i, int16_t j){
+        int16_t t = this->heap[i];
+        this->heap[i] = this->heap[j];
+        this->heap[j] = t;
+        this->pos[this->heap[i]] = i;
+        this->pos[this->heap[j]] = j;
+        return 1;
+    }
+
+    uint8_t compareExchange(int16_t i, int16_t j){
+        return this->less(i, j) && this->exchange(i, j);
+    }
+
+    int16_t minCount() const{ return (int16_t)((this->count - 1) / 2); }
+    int16_t maxCount() const{ return (int16_t)(this->count / 2); }
+
+    /*SORT FUNCTIONS: i is the first child to compare with its parent*/
+    void minSortDown(int16_t i){
+        for(; i <= this->minCount(); i *= 2){
+            if(i < this->minCount() && this->less(i + 1, i)) i++;
+            if(!this->compareExchange(i, i / 2)) break;
+        }
+    }
+
+    void maxSortDown(int16_t i){
+        for(; i >= -this->maxCount(); i *= 2){
+            if(i > -this->maxCount() && this->less(i, i - 1)) i--;
+            if(!this->compareExchange(i / 2, i)) break;
+        }
+    }
+
+    uint8_t minSortUp(int16_t i){
+        while(i > 0 && this->compareExchange(i, i / 2)) i /= 2;
+        return i == 0;
+    }
+
+    uint8_t maxSortUp(int16_t i){
+        while(i < 0 && this->compareExchange(i / 2, i)) i /= 2;
+        return i == 0;
+    }
+
+    int32_t data[N];
+    int16_t pos[N];
+    int16_t heapStorage[N];
+    int16_t* heap;
+    uint16_t index;
+    uint16_t count;
+};
+
+/**
+ * @brief Streaming Hampel filter: replaces outliers with the window median
+ * @param N: window size.
+ * @param KTenths: threshold in robust standard deviations * 10 (30 = 3 sigma).
+ * @note MAD is tracked as the running median of |x - median| taken at insertion time,
+ *       so both stages stay O(log N). A sample is an outlier when its deviation exceeds
+ *       K * 1.4826 * MAD
+ */
+template<uint16_t N, uint16_t KTenths = 30>
+class bmp_hampel{
+public:
+    bmp_hampel(){
+        this->outliers = 0;
+    }
+
+    /**
+     * @brief Filter one sample
+     * @retval Sample, or window median if sample is an outlier
+     */
+    int32_t process(int32_t value){
+        int32_t med = this->window.process(value);
+        int64_t deviation = (int64_t)value - med;
+        if(deviation < 0) deviation = -deviation;
+        int64_t mad = this->deviations.process((int32_t)(deviation > INT32_MAX ? INT32_MAX : deviation));
+        if(this->window.size() < N) return value;
+
+        // deviation > K/10 * 1.4826 * MAD, scaled by 10000
+        if(deviation * 10000 * 10 > (int64_t)KTenths * 14826 * mad){
+            this->outliers++;
+            return med;
+        }
+        return value;
+    }
+
+    /**
+     * @brief Number of replaced samples
+     */
+    uint32_t outlierCount() const{
+        return this->outliers;
+    }
+
+private:
+    bmp_median<N> window;
+    bmp_median<N> deviations;
+    uint32_t outliers;
+};
+
+#endif
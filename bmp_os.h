@@ -0,0 +1,290 @@
+/**
+ * @file bmp_os.h
+ * @author Denys Khmil
+ * @brief This file contents the OS abstraction (FreeRTOS, or std::thread with BMP_OS_HOST)
+ */
+#ifndef BMP_OS
+#define BMP_OS
+
+#include <stdint.h>
+
+/*TIMEOUTS*/
+#define BMP_OS_FOREVER 0xFFFFFFFFUL
+
+#ifndef BMP_OS_HOST
+/*---------------------------------------- FreeRTOS ----------------------------------------*/
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+inline TickType_t bmp_os_ticks(uint32_t timeout_ms){
+    return (timeout_ms == BMP_OS_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+}
+
+/**
+ * @brief Queue of T, storage is provided by bmp_os_static_queue
+ */
+template<typename T>
+class bmp_os_queue{
+public:
+    /**
+     * @brief Post item without blocking
+     * @retval 1 if posted, 0 if the queue is full
+     */
+    uint8_t send(const T& item){
+        return xQueueSend(this->handle, &item, 0) == pdTRUE;
+    }
+
+    /**
+     * @brief Wait for item
+     * @retval 1 if an item was received before timeout_ms
+     */
+    uint8_t receive(T* item, uint32_t timeout_ms){
+        return xQueueReceive(this->handle, item, bmp_os_ticks(timeout_ms)) == pdTRUE;
+    }
+
+    uint16_t waiting(){
+        return (uint16_t)uxQueueMessagesWaiting(this->handle);
+    }
+
+protected:
+    QueueHandle_t handle;
+};
+
+template<typename T, uint16_t Depth>
+class bmp_os_static_queue : public bmp_os_queue<T>{
+public:
+    bmp_os_static_queue(){
+        this->handle = xQueueCreateStatic(Depth, sizeof(T), this->storage, &this->control);
+    }
+
+private:
+    StaticQueue_t control;
+    uint8_t storage[Depth * sizeof(T)];
+};
+
+/**
+ * @brief Binary signal from an ISR (or task) to one waiting task
+ */
+class bmp_os_signal{
+public:
+    bmp_os_signal(){
+        this->handle = xSemaphoreCreateBinaryStatic(&this->control);
+    }
+
+    void give(){
+        xSemaphoreGive(this->handle);
+    }
+
+    void giveFromISR(){
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(this->handle, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    uint8_t take(uint32_t timeout_ms){
+        return xSemaphoreTake(this->handle, bmp_os_ticks(timeout_ms)) == pdTRUE;
+    }
+
+    void clear(){
+        xSemaphoreTake(this->handle, 0);
+    }
+
+private:
+    SemaphoreHandle_t handle;
+    StaticSemaphore_t control;
+};
+
+/**
+ * @brief Statically allocated task
+ * @note When entry returns the task signals completion and suspends itself; join() waits for
+ *       that signal and deletes the task, after which its stack and control block can be reused
+ */
+template<uint16_t StackWords>
+class bmp_os_thread{
+public:
+    bmp_os_thread(){
+        this->handle = 0;
+    }
+
+    uint8_t start(void (*_entry)(void*), void* _arg, const char* name, uint8_t priority){
+        this->entry = _entry;
+        this->arg = _arg;
+        this->finished.clear();
+        this->handle = xTaskCreateStatic(trampoline, name, StackWords, this, priority, this->stack, &this->control);
+        return this->handle != 0;
+    }
+
+    /**
+     * @brief Wait until entry returned (not from the task itself)
+     */
+    void join(){
+        if(!this->handle) return;
+        this->finished.take(BMP_OS_FOREVER);
+        /*deleting another task frees it at once, a self-delete would leave it to the idle task*/
+        vTaskDelete(this->handle);
+        this->handle = 0;
+    }
+
+private:
+    static void trampoline(void* self){
+        bmp_os_thread* thread = (bmp_os_thread*)self;
+        thread->entry(thread->arg);
+        thread->finished.give();
+        vTaskSuspend(0);
+    }
+
+    void (*entry)(void*);
+    void* arg;
+    TaskHandle_t handle;
+    bmp_os_signal finished;
+    StackType_t stack[StackWords];
+    StaticTask_t control;
+};
+
+/**
+ * @brief Fixed rate loop timing without drift
+ */
+class bmp_os_period{
+public:
+    void start(){
+        this->last = xTaskGetTickCount();
+    }
+
+    void wait(uint32_t period_ms){
+        vTaskDelayUntil(&this->last, pdMS_TO_TICKS(period_ms));
+    }
+
+private:
+    TickType_t last;
+};
+
+#else
+/*---------------------------------------- std::thread ----------------------------------------*/
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+template<typename T>
+class bmp_os_queue{
+public:
+    uint8_t send(const T& item){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if(this->count == this->depth) return 0;
+        this->buffer[(this->head + this->count) % this->depth] = item;
+        this->count++;
+        this->ready.notify_one();
+        return 1;
+    }
+
+    uint8_t receive(T* item, uint32_t timeout_ms){
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(timeout_ms == BMP_OS_FOREVER) this->ready.wait(lock, [this]{ return this->count > 0; });
+        else if(!this->ready.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]{ return this->count > 0; })) return 0;
+        *item = this->buffer[this->head];
+        this->head = (uint16_t)((this->head + 1) % this->depth);
+        this->count--;
+        return 1;
+    }
+
+    uint16_t waiting(){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->count;
+    }
+
+protected:
+    bmp_os_queue(T* _buffer, uint16_t _depth) : buffer(_buffer), depth(_depth), head(0), count(0){}
+    bmp_os_queue(const bmp_os_queue&) = delete;
+    bmp_os_queue& operator=(const bmp_os_queue&) = delete;
+
+private:
+    T* buffer;
+    uint16_t depth;
+    uint16_t head;
+    uint16_t count;
+    std::mutex mutex;
+    std::condition_variable ready;
+};
+
+template<typename T, uint16_t Depth>
+class bmp_os_static_queue : public bmp_os_queue<T>{
+public:
+    bmp_os_static_queue() : bmp_os_queue<T>(this->storage, Depth){}
+
+private:
+    T storage[Depth];
+};
+
+class bmp_os_signal{
+public:
+    bmp_os_signal() : given(0){}
+
+    void give(){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->given = 1;
+        this->ready.notify_one();
+    }
+
+    void giveFromISR(){
+        this->give();
+    }
+
+    uint8_t take(uint32_t timeout_ms){
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(timeout_ms == BMP_OS_FOREVER) this->ready.wait(lock, [this]{ return this->given != 0; });
+        else if(!this->ready.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]{ return this->given != 0; })) return 0;
+        this->given = 0;
+        return 1;
+    }
+
+    void clear(){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->given = 0;
+    }
+
+private:
+    uint8_t given;
+    std::mutex mutex;
+    std::condition_variable ready;
+};
+
+template<uint16_t StackWords>
+class bmp_os_thread{
+public:
+    uint8_t start(void (*entry)(void*), void* arg, const char*, uint8_t){
+        this->thread = std::thread(entry, arg);
+        return 1;
+    }
+
+    void join(){
+        if(this->thread.joinable()) this->thread.join();
+    }
+
+    ~bmp_os_thread(){
+        this->join();
+    }
+
+private:
+    std::thread thread;
+};
+
+class bmp_os_period{
+public:
+    void start(){
+        this->last = std::chrono::steady_clock::now();
+    }
+
+    void wait(uint32_t period_ms){
+        this->last += std::chrono::milliseconds(period_ms);
+        std::this_thread::sleep_until(this->last);
+    }
+
+private:
+    std::chrono::steady_clock::time_point last;
+};
+
+#endif
+
+#endif
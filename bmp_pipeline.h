@@ -0,0 +1,203 @@
+/**
+ * @file bmp_pipeline.h
+ * @author Denys Khmil
+ * @brief This file contents the compile-time pipeline of sample processing stages
+ */
+#ifndef BMP_PIPELINE
+#define BMP_PIPELINE
+
+#include <stdint.h>
+#include "bmp_sample.h"
+#include "bmp_sensor.h"
+
+/*CHANNELS*/
+#define BMP_STAGE_TEMPERATURE   0
+#define BMP_STAGE_PRESSURE      1
+#define BMP_STAGE_HUMIDITY      2
+
+/**
+ * @brief Chain of stages composed at compile time, e.g.
+ *        bmp_pipeline<bmp_compensate_stage<bmp280>, bmp_filter_stage<Lowpass>, bmp_decimate_stage<4>, bmp_publish_stage<Sink> >
+ * @note A stage is any type with template<typename Next> void process(const T& value, Next& next)
+ *       that calls next.push(result) zero or more times, and void reset().
+ *       Stages are members of the pipeline: no virtual calls, no heap, every call can be inlined
+ */
+template<typename... Stages>
+class bmp_pipeline;
+
+namespace bmp_pipeline_detail{
+
+template<uint8_t Index>
+struct stage_of{
+    template<typename Pipeline>
+    static auto& get(Pipeline& pipeline){ return stage_of<Index - 1>::get(pipeline.tail()); }
+};
+
+template<>
+struct stage_of<0>{
+    template<typename Pipeline>
+    static auto& get(Pipeline& pipeline){ return pipeline.head(); }
+};
+
+}
+
+template<>
+class bmp_pipeline<>{
+public:
+    template<typename T>
+    void push(const T&){}
+    void reset(){}
+};
+
+template<typename First, typename... Rest>
+class bmp_pipeline<First, Rest...>{
+public:
+    /**
+     * @brief Feed value to the first stage
+     */
+    template<typename T>
+    void push(const T& value){
+        this->first.process(value, this->rest);
+    }
+
+    /**
+     * @brief Read one raw frame from sensor and feed it to the first stage
+     * @retval 1 if the read succeeded (status 0)
+     */
+    template<BMP_SENSOR Sensor>
+    uint8_t acquire(Sensor& sensor){
+        bmp_raw raw;
+        if(sensor.readRaw(&raw) != 0) return 0;
+        this->push(raw);
+        return 1;
+    }
+
+    /**
+     * @brief Reset state of all stages
+     */
+    void reset(){
+        this->first.reset();
+        this->rest.reset();
+    }
+
+    /**
+     * @brief Access stage by position (0 is the first stage)
+     */
+    template<uint8_t Index>
+    auto& stage(){
+        return bmp_pipeline_detail::stage_of<Index>::get(*this);
+    }
+
+    First& head(){ return this->first; }
+    bmp_pipeline<Rest...>& tail(){ return this->rest; }
+
+private:
+    First first;
+    bmp_pipeline<Rest...> rest;
+};
+
+/**
+ * @brief Raw frame to compensated sample with the calibration of a sensor
+ * @note bind() the sensor before the first frame
+ */
+template<typename Sensor>
+class bmp_compensate_stage{
+public:
+    bmp_compensate_stage(){
+        this->sensor = 0;
+    }
+
+    void bind(Sensor* _sensor){
+        this->sensor = _sensor;
+    }
+
+    template<typename Next>
+    void process(const bmp_raw& raw, Next& next){
+        bmp_sample sample;
+        this->sensor->compensate(&raw, &sample);
+        next.push(sample);
+    }
+
+    void reset(){}
+
+private:
+    Sensor* sensor;
+};
+
+/**
+ * @brief Filter one channel of compensated samples
+ * @param Filter: any type with int32_t process(int32_t), e.g. bmp_biquad, bmp_cascade, bmp_median.
+ * @param Channel: BMP_STAGE_TEMPERATURE, BMP_STAGE_PRESSURE or BMP_STAGE_HUMIDITY.
+ * @note Filter several channels with one stage per channel
+ */
+template<typename Filter, uint8_t Channel = BMP_STAGE_PRESSURE>
+class bmp_filter_stage{
+public:
+    template<typename Next>
+    void process(const bmp_sample& sample, Next& next){
+        bmp_sample out = sample;
+        if(Channel == BMP_STAGE_TEMPERATURE) out.temperature = this->filter.process(sample.temperature);
+        else if(Channel == BMP_STAGE_PRESSURE) out.pressure = (uint32_t)this->filter.process((int32_t)sample.pressure);
+        else out.humidity = (uint32_t)this->filter.process((int32_t)sample.humidity);
+        next.push(out);
+    }
+
+    void reset(){
+        this->filter = Filter();
+    }
+
+    Filter& get(){ return this->filter; }
+
+private:
+    Filter filter;
+};
+
+/**
+ * @brief Pass every Factor-th value
+ * @note No anti-aliasing of its own, put a low-pass stage in front of it
+ */
+template<uint16_t Factor>
+class bmp_decimate_stage{
+    static_assert(Factor >= 1, "factor must not be 0");
+public:
+    bmp_decimate_stage(){
+        this->count = 0;
+    }
+
+    template<typename T, typename Next>
+    void process(const T& value, Next& next){
+        if(++this->count < Factor) return;
+        this->count = 0;
+        next.push(value);
+    }
+
+    void reset(){
+        this->count = 0;
+    }
+
+private:
+    uint16_t count;
+};
+
+/**
+ * @brief Hand value to a sink and pass it on
+ * @param Sink: default constructible functor called as sink(value).
+ */
+template<typename Sink>
+class bmp_publish_stage{
+public:
+    template<typename T, typename Next>
+    void process(const T& value, Next& next){
+        this->sink(value);
+        next.push(value);
+    }
+
+    void reset(){}
+
+    Sink& get(){ return this->sink; }
+
+private:
+    Sink sink;
+};
+
+#endif
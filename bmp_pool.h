@@ -0,0 +1,111 @@
+/**
+ * @file bmp_pool.h
+ * @author Denys Khmil
+ * @brief This file contents the lock-free fixed-block pool of sample objects
+ */
+#ifndef BMP_POOL
+#define BMP_POOL
+
+#include <stdint.h>
+#include <atomic>
+
+/*FREE LIST END*/
+#define BMP_POOL_NONE 0xFFFF
+
+/**
+ * @brief Fixed-block pool for handing sample objects between tasks by pointer
+ * @param T: block type (e.g. bmp_sample, bmp_raw or a frame struct).
+ * @param N: number of blocks (< BMP_POOL_NONE).
+ * @note Free list is a Treiber stack of block indices; the head word carries a 16 bit tag
+ *       bumped on every push/pop, so a stale compare-and-swap cannot succeed (ABA).
+ *       acquire()/release() are lock-free and may be called from tasks and ISRs alike.
+ *       Ownership moves with the pointer: whoever holds it last calls release().
+ *       Blocks can also travel as 16 bit indices (indexOf()/at()) through RTOS queues.
+ *       available() stays within 0..N, it may count a block a release is still pushing
+ */
+template<typename T, uint16_t N>
+class bmp_pool{
+    static_assert(N >= 1 && N < BMP_POOL_NONE, "pool size out of range");
+public:
+    bmp_pool(){
+        for(uint16_t i = 0; i < N; i++) this->next[i].store((uint16_t)(i + 1 < N ? i + 1 : BMP_POOL_NONE), std::memory_order_relaxed);
+        this->head.store(0, std::memory_order_relaxed);
+        this->freeBlocks.store(N, std::memory_order_relaxed);
+        this->lowWater.store(N, std::memory_order_relaxed);
+        this->failures.store(0, std::memory_order_relaxed);
+    }
+
+    bmp_pool(const bmp_pool&) = delete;
+    bmp_pool& operator=(const bmp_pool&) = delete;
+
+    /**
+     * @brief Take one block
+     * @retval Block, 0 if the pool is exhausted (counted in exhausted())
+     */
+    T* acquire(){
+        uint32_t old_head = this->head.load(std::memory_order_acquire);
+        for(;;){
+            uint16_t index = (uint16_t)old_head;
+            if(index == BMP_POOL_NONE){
+                this->failures.fetch_add(1, std::memory_order_relaxed);
+                return 0;
+            }
+            uint32_t new_head = nextTag(old_head) | this->next[index].load(std::memory_order_relaxed);
+            if(this->head.compare_exchange_weak(old_head, new_head, std::memory_order_acquire, std::memory_order_acquire)){
+                uint16_t left = (uint16_t)(this->freeBlocks.fetch_sub(1, std::memory_order_relaxed) - 1);
+                uint16_t low = this->lowWater.load(std::memory_order_relaxed);
+                while(left < low && !this->lowWater.compare_exchange_weak(low, left, std::memory_order_relaxed)){}
+                return &this->blocks[index];
+            }
+        }
+    }
+
+    /**
+     * @brief Return block to the pool
+     * @param block: block from acquire() of this pool (0 is ignored).
+     */
+    void release(T* block){
+        if(!block) return;
+        uint16_t index = this->indexOf(block);
+        /*counted before the push, so an acquire of this block always finds it counted*/
+        this->freeBlocks.fetch_add(1, std::memory_order_relaxed);
+        uint32_t old_head = this->head.load(std::memory_order_relaxed);
+        do{
+            this->next[index].store((uint16_t)old_head, std::memory_order_relaxed);
+        }while(!this->head.compare_exchange_weak(old_head, nextTag(old_head) | index, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Index of block, for passing it through a queue of uint16_t
+     */
+    uint16_t indexOf(const T* block) const{
+        return (uint16_t)(block - this->blocks);
+    }
+
+    /**
+     * @brief Block of index
+     */
+    T* at(uint16_t index){
+        return &this->blocks[index];
+    }
+
+    /*COUNTERS*/
+    uint16_t capacity() const{ return N; }
+    uint16_t available() const{ return this->freeBlocks.load(std::memory_order_relaxed); }
+    uint16_t minAvailable() const{ return this->lowWater.load(std::memory_order_relaxed); }
+    uint32_t exhausted() const{ return this->failures.load(std::memory_order_relaxed); }
+
+private:
+    static uint32_t nextTag(uint32_t word){
+        return (word & 0xFFFF0000UL) + 0x10000UL;
+    }
+
+    T blocks[N];
+    std::atomic<uint16_t> next[N];
+    std::atomic<uint32_t> head;
+    std::atomic<uint16_t> freeBlocks;
+    std::atomic<uint16_t> lowWater;
+    std::atomic<uint32_t> failures;
+};
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * @file bmp_resample.cpp
+ * @author Denys Khmil
+ * @brief This file contents the resampling functions
+ */
+#include "bmp_resample.h"
+
+/*HERMITE BASIS FRACTION*/
+#define BMP_RESAMPLE_SHIFT 16
+
+/**
+ * @brief Empty stream
+ * @param _mode: BMP_RESAMPLE_LINEAR or BMP_RESAMPLE_CUBIC.
+ */
+bmp_resampler::bmp_resampler(uint8_t _mode){
+    this->mode = _mode;
+    this->reset();
+}
+
+
+/**
+ * @brief Add sample, the oldest one is dropped when the history is full
+ * @param time_us: sample time (must increase).
+ */
+void bmp_resampler::push(uint32_t time_us, const bmp_sample* sample){
+    this->head = (uint8_t)((this->head + 1) % BMP_RESAMPLE_HISTORY);
+    this->times[this->head] = time_us;
+    this->samples[this->head] = *sample;
+    if(this->count < BMP_RESAMPLE_HISTORY) this->count++;
+}
+
+
+/**
+ * @brief Change interpolation, the history is kept
+ */
+void bmp_resampler::setMode(uint8_t _mode){
+    this->mode = _mode;
+}
+
+
+/**
+ * @brief Forget all samples
+ */
+void bmp_resampler::reset(){
+    this->head = BMP_RESAMPLE_HISTORY - 1;
+    this->count = 0;
+}
+
+
+/**
+ * @brief Interpolate stream at time
+ * @param sample: interpolated values (only written on BMP_RESAMPLE_OK).
+ * @retval BMP_RESAMPLE_OK, BMP_RESAMPLE_WAIT if time is not covered yet,
+ *         BMP_RESAMPLE_LATE if time is older than the history
+ */
+int8_t bmp_resampler::at(uint32_t time_us, bmp_sample* sample) const{
+    uint8_t cubic = (this->mode == BMP_RESAMPLE_CUBIC);
+    uint8_t need = cubic ? 4 : 2;
+    if(this->count < need) return this->count ? (((int32_t)(time_us - this->oldest()) < 0) ? BMP_RESAMPLE_LATE : BMP_RESAMPLE_WAIT) : BMP_RESAMPLE_WAIT;
+
+    /*segment [t1, t2] by age: t2 is age a2, t1 age a2 + 1; cubic keeps one sample newer than t2*/
+    uint8_t a2 = cubic ? 1 : 0;
+    if((int32_t)(time_us - this->timeOf(a2)) > 0) return BMP_RESAMPLE_WAIT;
+    while((int32_t)(time_us - this->timeOf(a2 + 1)) < 0){
+        if(a2 + 1 + cubic >= this->count - 1) return BMP_RESAMPLE_LATE;
+        a2++;
+    }
+
+    uint32_t t1 = this->timeOf(a2 + 1);
+    int32_t t = (int32_t)(time_us - t1);
+    int32_t t2 = (int32_t)(this->timeOf(a2) - t1);
+    const bmp_sample& s1 = this->sampleOf(a2 + 1);
+    const bmp_sample& s2 = this->sampleOf(a2);
+    if(t2 <= 0){
+        *sample = s2;
+        return BMP_RESAMPLE_OK;
+    }
+
+    if(!cubic){
+        int64_t u = ((int64_t)t << BMP_RESAMPLE_SHIFT) / t2;
+        sample->temperature = lerp(s1.temperature, s2.temperature, u);
+        sample->pressure = (uint32_t)lerp(s1.pressure, s2.pressure, u);
+        sample->humidity = (uint32_t)lerp(s1.humidity, s2.humidity, u);
+        return BMP_RESAMPLE_OK;
+    }
+
+    int32_t t0 = (int32_t)(this->timeOf(a2 + 2) - t1);
+    int32_t t3 = (int32_t)(this->timeOf(a2 - 1) - t1);
+    const bmp_sample& s0 = this->sampleOf(a2 + 2);
+    const bmp_sample& s3 = this->sampleOf(a2 - 1);
+    sample->temperature = interpolate(s0.temperature, s1.temperature, s2.temperature, s3.temperature, t0, t2, t3, t);
+    sample->pressure = (uint32_t)interpolate(s0.pressure, s1.pressure, s2.pressure, s3.pressure, t0, t2, t3, t);
+    sample->humidity = (uint32_t)interpolate(s0.humidity, s1.humidity, s2.humidity, s3.humidity, t0, t2, t3, t);
+    return BMP_RESAMPLE_OK;
+}
+
+
+/**
+ * @brief Number of samples in the history
+ */
+uint8_t bmp_resampler::size() const{
+    return this->count;
+}
+
+
+/**
+ * @brief Time of the oldest sample in the history
+ */
+uint32_t bmp_resampler::oldest() const{
+    return this->timeOf(this->count ? this->count - 1 : 0);
+}
+
+
+/**
+ * @brief Time of the newest sample
+ */
+uint32_t bmp_resampler::newest() const{
+    return this->timeOf(0);
+}
+
+
+/**
+ * @brief Time of sample by age (0 = newest)
+ */
+uint32_t bmp_resampler::timeOf(uint8_t age) const{
+    return this->times[(this->head + BMP_RESAMPLE_HISTORY - age) % BMP_RESAMPLE_HISTORY];
+}
+
+
+/**
+ * @brief Sample by age (0 = newest)
+ */
+const bmp_sample& bmp_resampler::sampleOf(uint8_t age) const{
+    return this->samples[(this->head + BMP_RESAMPLE_HISTORY - age) % BMP_RESAMPLE_HISTORY];
+}
+
+
+/**
+ * @brief Linear interpolation
+ * @param u: position between p1 and p2 in Q(BMP_RESAMPLE_SHIFT).
+ * @retval Interpolated value (rounded)
+ */
+int32_t bmp_resampler::lerp(int64_t p1, int64_t p2, int64_t u){
+    int64_t value = (p1 << BMP_RESAMPLE_SHIFT) + (p2 - p1) * u;
+    return (int32_t)((value + (1LL << (BMP_RESAMPLE_SHIFT - 1))) >> BMP_RESAMPLE_SHIFT);
+}
+
+
+/**
+ * @brief Cubic Hermite on [0, t2] with Catmull-Rom tangents, times relative to t1 = 0
+ * @param t0: time of p0 (< 0), t3: time of p3 (> t2).
+ * @retval Interpolated value at t (rounded)
+ */
+int32_t bmp_resampler::interpolate(int64_t p0, int64_t p1, int64_t p2, int64_t p3,
+                                   int32_t t0, int32_t t2, int32_t t3, int32_t t){
+    int64_t one = 1LL << BMP_RESAMPLE_SHIFT;
+    int64_t u = ((int64_t)t << BMP_RESAMPLE_SHIFT) / t2;
+
+    /*tangents scaled to the segment length*/
+    int64_t m1 = (p2 - p0) * t2 / (t2 - t0);
+    int64_t m2 = (p3 - p1) * t2 / t3;
+    int64_t u2 = (u * u) >> BMP_RESAMPLE_SHIFT;
+    int64_t u3 = (u2 * u) >> BMP_RESAMPLE_SHIFT;
+    int64_t h00 = 2 * u3 - 3 * u2 + one;
+    int64_t h10 = u3 - 2 * u2 + u;
+    int64_t h01 = -2 * u3 + 3 * u2;
+    int64_t h11 = u3 - u2;
+    int64_t value = h00 * p1 + h10 * m1 + h01 * p2 + h11 * m2;
+    return (int32_t)((value + one / 2) >> BMP_RESAMPLE_SHIFT);
+}
+
+
+/**
+ * @brief Streams sharing one output clock
+ * @param _streams: resamplers, one per sensor.
+ * @param _count: number of streams (up to BMP_RESAMPLE_MAX_STREAMS).
+ * @param _period_us: output period.
+ */
+bmp_resample_bank::bmp_resample_bank(bmp_resampler* _streams, uint8_t _count, uint32_t _period_us){
+    this->streams = _streams;
+    this->count = (_count > BMP_RESAMPLE_MAX_STREAMS) ? BMP_RESAMPLE_MAX_STREAMS : _count;
+    this->period = _period_us;
+    this->tick = 0;
+    this->started = 0;
+    this->skips = 0;
+}
+
+
+/**
+ * @brief Set time of the next output tick
+ */
+void bmp_resample_bank::start(uint32_t time_us){
+    this->tick = time_us;
+    this->started = 1;
+}
+
+
+/**
+ * @brief Produce the next output tick if every stream covers it
+ * @param samples: one interpolated sample per stream.
+ * @param time_us: time of the tick.
+ * @retval 1 if a tick was produced, 0 if some stream has to wait for input
+ */
+uint8_t bmp_resample_bank::next(bmp_sample* samples, uint32_t* time_us){
+    if(!this->started && !this->autoStart()) return 0;
+    for(;;){
+        uint8_t late = 0;
+        for(uint8_t i = 0; i < this->count; i++){
+            int8_t result = this->streams[i].at(this->tick, &samples[i]);
+            if(result == BMP_RESAMPLE_WAIT) return 0;
+            if(result == BMP_RESAMPLE_LATE) late = 1;
+        }
+        if(!late) break;
+        this->tick += this->period;
+        this->skips++;
+    }
+    *time_us = this->tick;
+    this->tick += this->period;
+    return 1;
+}
+
+
+/**
+ * @brief Output ticks skipped because a stream had already dropped them
+ */
+uint32_t bmp_resample_bank::skipped() const{
+    return this->skips;
+}
+
+
+/**
+ * @brief Start the clock at the latest oldest sample of all streams
+ */
+uint8_t bmp_resample_bank::autoStart(){
+    uint32_t first = 0;
+    for(uint8_t i = 0; i < this->count; i++){
+        if(this->streams[i].size() < BMP_RESAMPLE_HISTORY) return 0;
+        uint32_t oldest = this->streams[i].oldest();
+        if(!i || (int32_t)(oldest - first) > 0) first = oldest;
+    }
+    this->start(first + this->period);
+    return 1;
+}
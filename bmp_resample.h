@@ -0,0 +1,89 @@
+/**
+ * @file bmp_resample.h
+ * @author Denys Khmil
+ * @brief This file contents the resampling of timestamped streams onto a common timebase
+ */
+#ifndef BMP_RESAMPLE
+#define BMP_RESAMPLE
+
+#include <stdint.h>
+#include "bmp_sample.h"
+
+/*INTERPOLATION*/
+#define BMP_RESAMPLE_LINEAR     0
+#define BMP_RESAMPLE_CUBIC      1
+
+/*RESULTS OF at()*/
+#define BMP_RESAMPLE_OK         1
+#define BMP_RESAMPLE_WAIT       0
+#define BMP_RESAMPLE_LATE       -1
+
+#define BMP_RESAMPLE_HISTORY    8
+#define BMP_RESAMPLE_MAX_STREAMS 16
+
+/**
+ * @brief Interpolator of one timestamped stream
+ * @note Keeps the last BMP_RESAMPLE_HISTORY samples only. Linear needs the two samples around
+ *       the output time, cubic (Hermite with Catmull-Rom tangents on the real timestamps, so
+ *       uneven input spacing is fine) one more on each side and so lags one input sample.
+ *       The spare history lets streams with faster clocks run ahead of the slowest one.
+ *       Integer arithmetic, timestamps are wrapping us counters
+ */
+class bmp_resampler{
+public:
+    /*CONSTRUCTORS*/
+    bmp_resampler(uint8_t _mode = BMP_RESAMPLE_LINEAR);
+
+    /*UPDATE*/
+    void push(uint32_t time_us, const bmp_sample* sample);
+    void setMode(uint8_t _mode);
+    void reset();
+
+    /*QUERIES*/
+    int8_t at(uint32_t time_us, bmp_sample* sample) const;
+    uint8_t size() const;
+    uint32_t oldest() const;
+    uint32_t newest() const;
+
+private:
+    uint32_t timeOf(uint8_t age) const;
+    const bmp_sample& sampleOf(uint8_t age) const;
+    static int32_t lerp(int64_t p1, int64_t p2, int64_t u);
+    static int32_t interpolate(int64_t p0, int64_t p1, int64_t p2, int64_t p3,
+                               int32_t t0, int32_t t2, int32_t t3, int32_t t);
+
+    uint32_t times[BMP_RESAMPLE_HISTORY];
+    bmp_sample samples[BMP_RESAMPLE_HISTORY];
+    uint8_t head;
+    uint8_t count;
+    uint8_t mode;
+};
+
+/**
+ * @brief Set of streams resampled onto one output clock
+ * @note Push input into the streams as it arrives, then drain next() until it returns 0.
+ *       The clock starts at the first instant every stream can interpolate, unless start()
+ *       sets it. A tick some stream has already dropped from its history is skipped (skipped())
+ */
+class bmp_resample_bank{
+public:
+    /*CONSTRUCTORS*/
+    bmp_resample_bank(bmp_resampler* _streams, uint8_t _count, uint32_t _period_us);
+
+    /*CLOCK*/
+    void start(uint32_t time_us);
+    uint8_t next(bmp_sample* samples, uint32_t* time_us);
+    uint32_t skipped() const;
+
+private:
+    uint8_t autoStart();
+
+    bmp_resampler* streams;
+    uint8_t count;
+    uint32_t period;
+    uint32_t tick;
+    uint8_t started;
+    uint32_t skips;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @file bmp_sample.h
+ * @author Denys Khmil
+ * @brief This file contents the raw and compensated sample types shared by the library
+ */
+#ifndef BMP_SAMPLE
+#define BMP_SAMPLE
+
+#include <stdint.h>
+
+/*UNIT CONVERSIONS*/
+#define BMP_TEMPERATURE_SCALE 100.0
+#define BMP_PRESSURE_SCALE    256.0
+#define BMP_HUMIDITY_SCALE    1024.0
+
+/**
+ * @brief Uncompensated adc values of one measurement
+ * @note humidity is 0 for sensors without humidity channel
+ */
+struct bmp_raw{
+    int32_t temperature;
+    int32_t pressure;
+    int32_t humidity;
+};
+
+/**
+ * @brief Compensated fixed-point values of one measurement
+ * @note temperature in 0.01 degC, pressure in Pa as Q24.8, humidity in %RH as Q22.10
+ */
+struct bmp_sample{
+    int32_t temperature;
+    uint32_t pressure;
+    uint32_t humidity;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * @file bmp_sensor.h
+ * @author Denys Khmil
+ * @brief This file contents the compile-time pressure sensor interface
+ */
+#ifndef BMP_SENSOR_LIB
+#define BMP_SENSOR_LIB
+
+#include <stdint.h>
+#include "bmp_sample.h"
+
+/**
+ * @brief Pressure sensor interface modeled by bmp280 and bmp388
+ * @note readRaw(): one burst read of all data registers, returns HAL status.
+ *       compensate(): integer conversion of a raw frame, no bus access.
+ *       settings(): oversampling of pressure, temperature and sensor mode.
+ *       getStatus(): HAL status of the last transfer.
+ *       Generic code is written as template<BMP_SENSOR Sensor>, which is the
+ *       bmp_sensor concept on C++20 and an unconstrained typename before.
+ */
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+#include <concepts>
+
+template<typename Sensor>
+concept bmp_sensor = requires(Sensor& sensor, bmp_raw* raw, const bmp_raw* raw_in, bmp_sample* sample, uint8_t value){
+    { sensor.readRaw(raw) } -> std::convertible_to<int>;
+    sensor.compensate(raw_in, sample);
+    sensor.settings(value, value, value);
+    { sensor.getStatus() } -> std::convertible_to<int>;
+};
+
+#define BMP_SENSOR bmp_sensor
+#else
+#define BMP_SENSOR typename
+#endif
+
+/**
+ * @brief Read and compensate one sample from any sensor
+ * @param sensor: sensor modeling bmp_sensor.
+ * @param sample: compensated values.
+ * @retval 1 if the read succeeded (status 0)
+ */
+template<BMP_SENSOR Sensor>
+inline uint8_t bmp_acquire(Sensor& sensor, bmp_sample* sample){
+    bmp_raw raw;
+    if(sensor.readRaw(&raw) != 0) return 0;
+    sensor.compensate(&raw, sample);
+    return 1;
+}
+
+#endif
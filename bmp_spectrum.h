@@ -0,0 +1,255 @@
+/**
+ * @file bmp_spectrum.h
+ * @author Denys Khmil
+ * @brief This file contents the windowed FFT band energy stage for pressure streams
+ */
+#ifndef BMP_SPECTRUM
+#define BMP_SPECTRUM
+
+#include <stdint.h>
+#include "bmp_sample.h"
+#include "bmp_filter.h"
+
+#define BMP_SPECTRUM_MAX_BANDS 8
+
+namespace bmp_spectrum_detail{
+
+/**
+ * @brief Cosine on [0, 2 pi) from the |x| <= pi series
+ */
+constexpr double cos2pi(double x){
+    return (x > bmp_filter_detail::pi) ? -bmp_filter_detail::cos(x - bmp_filter_detail::pi) : bmp_filter_detail::cos(x);
+}
+
+/**
+ * @brief log2 of a power of 2
+ */
+constexpr uint16_t log2(uint16_t value){
+    return (value > 1) ? (uint16_t)(1 + log2((uint16_t)(value >> 1))) : 0;
+}
+
+/**
+ * @brief Hann window and N-point twiddles, built at compile time
+ * @note twiddle[k] = exp(-2 pi i k / N) for k = 0..N/2, the N/2 point FFT uses the even ones
+ */
+template<uint16_t N>
+struct tables{
+    float window[N];
+    float twiddleRe[N / 2 + 1];
+    float twiddleIm[N / 2 + 1];
+    float windowPower;
+
+    constexpr tables() : window(), twiddleRe(), twiddleIm(), windowPower(0){
+        double power = 0;
+        for(uint16_t i = 0; i < N; i++){
+            double w = 0.5 - 0.5 * cos2pi(2 * bmp_filter_detail::pi * i / N);
+            this->window[i] = (float)w;
+            power += w * w;
+        }
+        this->windowPower = (float)power;
+        for(uint16_t k = 0; k <= N / 2; k++){
+            double angle = 2 * bmp_filter_detail::pi * k / N;
+            this->twiddleRe[k] = (float)bmp_filter_detail::cos(angle);
+            this->twiddleIm[k] = (float)-bmp_filter_detail::sin(angle);
+        }
+    }
+};
+
+}
+
+/**
+ * @brief Windowed N-point real FFT of the pressure channel with band energy features
+ * @param N: frame length, power of 2 (16..1024).
+ * @note Each sample is windowed into the bit-reversed slot of the fill buffer. When a frame
+ *       is complete the buffers swap and the transform (N/2 point complex radix-2 of the
+ *       packed real input, then the real split and band sums) runs in equal slices during
+ *       the next N samples, so every push() costs the same bounded work.
+ *       Frames do not overlap; pressure is taken relative to the first sample of its frame.
+ *       band() is the mean square in Pa^2 of the last finished frame, frames() counts them
+ */
+template<uint16_t N>
+class bmp_spectrum{
+    static_assert(N >= 16 && N <= 1024 && (N & (N - 1)) == 0, "frame length must be a power of 2");
+public:
+    /**
+     * @param _sample_mhz: sample rate in mHz (for band edges in mHz).
+     */
+    bmp_spectrum(uint32_t _sample_mhz){
+        this->sampleMilliHz = _sample_mhz;
+        this->bandCount = 0;
+        this->reset();
+    }
+
+    /**
+     * @brief Add band of bins closest to low..high mHz
+     * @retval Band index, -1 if the table is full
+     */
+    int8_t addBand(uint32_t low_mhz, uint32_t high_mhz){
+        if(this->bandCount >= BMP_SPECTRUM_MAX_BANDS || high_mhz < low_mhz) return -1;
+        this->bandLow[this->bandCount] = this->binOf(low_mhz);
+        this->bandHigh[this->bandCount] = this->binOf(high_mhz);
+        this->energy[this->bandCount] = 0;
+        this->result[this->bandCount] = 0;
+        return (int8_t)this->bandCount++;
+    }
+
+    /**
+     * @brief Drop partial frame and pending transform
+     */
+    void reset(){
+        this->fill = this->buffers[0];
+        this->work = this->buffers[1];
+        this->position = 0;
+        this->phase = idle;
+        this->finished = 0;
+    }
+
+    /**
+     * @brief Add one pressure sample
+     * @param pressure: Q24.8 Pa.
+     */
+    void push(uint32_t pressure){
+        const bmp_spectrum_detail::tables<N>& t = table();
+        if(!this->position) this->reference = pressure;
+        float x = (float)((int32_t)(pressure - this->reference)) * (1.0f / BMP_PRESSURE_SCALE) * t.window[this->position];
+        uint16_t slot = reverse(this->position >> 1);
+        this->fill[2 * slot + (this->position & 1)] = x;
+
+        this->step(slices);
+        if(++this->position == N){
+            this->step(total);
+            float* swap = this->fill;
+            this->fill = this->work;
+            this->work = swap;
+            this->position = 0;
+            this->begin();
+        }
+    }
+
+    /**
+     * @brief Pipeline stage form (see bmp_pipeline), the input is passed on unchanged
+     */
+    template<typename Next>
+    void process(const bmp_sample& sample, Next& next){
+        this->push(sample.pressure);
+        next.push(sample);
+    }
+
+    /*QUERIES*/
+    float band(uint8_t index) const{ return (index < this->bandCount) ? this->result[index] : 0.0f; }
+    uint32_t frames() const{ return this->finished; }
+    uint16_t binOf(uint32_t frequency_mhz) const{
+        uint32_t bin = (uint32_t)(((uint64_t)frequency_mhz * N + this->sampleMilliHz / 2) / this->sampleMilliHz);
+        return (uint16_t)((bin > M) ? M : bin);
+    }
+
+private:
+    static const uint16_t M = N / 2;
+    static const uint16_t butterflies = (M / 2) * bmp_spectrum_detail::log2(M);
+    static const uint32_t total = butterflies + M + 1;
+    static const uint32_t slices = (total + N - 2) / (N - 1);
+
+    enum phase_t{ idle, transform, split };
+
+    static const bmp_spectrum_detail::tables<N>& table(){
+        static constexpr bmp_spectrum_detail::tables<N> t{};
+        return t;
+    }
+
+    static uint16_t reverse(uint16_t index){
+        uint16_t result = 0;
+        for(uint16_t bit = 1; bit < M; bit <<= 1){
+            result = (uint16_t)((result << 1)|(index & 1));
+            index >>= 1;
+        }
+        return result;
+    }
+
+    void begin(){
+        this->phase = transform;
+        this->half = 1;
+        this->unit = 0;
+        for(uint8_t i = 0; i < this->bandCount; i++) this->energy[i] = 0;
+    }
+
+    /**
+     * @brief Run up to budget units of the pending transform
+     */
+    void step(uint32_t budget){
+        const bmp_spectrum_detail::tables<N>& t = table();
+        while(budget-- && this->phase != idle){
+            if(this->phase == transform){
+                uint16_t j = this->unit & (this->half - 1);
+                uint16_t a = (uint16_t)(((this->unit - j) << 1) + j);
+                uint16_t b = a + this->half;
+                uint16_t tw = (uint16_t)(j * (M / this->half));
+                float* z = this->work;
+                float vr = z[2 * b] * t.twiddleRe[tw] - z[2 * b + 1] * t.twiddleIm[tw];
+                float vi = z[2 * b] * t.twiddleIm[tw] + z[2 * b + 1] * t.twiddleRe[tw];
+                z[2 * b] = z[2 * a] - vr;
+                z[2 * b + 1] = z[2 * a + 1] - vi;
+                z[2 * a] += vr;
+                z[2 * a + 1] += vi;
+                if(++this->unit == M / 2){
+                    this->unit = 0;
+                    this->half <<= 1;
+                    if(this->half == M) this->phase = split;
+                }
+            }
+            else{
+                this->splitBin(this->unit);
+                if(++this->unit > M) this->finish();
+            }
+        }
+    }
+
+    /**
+     * @brief Bin k of the real spectrum from the packed transform, added to its bands
+     */
+    void splitBin(uint16_t k){
+        const bmp_spectrum_detail::tables<N>& t = table();
+        const float* z = this->work;
+        uint16_t m = (uint16_t)((M - k) & (M - 1));
+        uint16_t n = (uint16_t)(k & (M - 1));
+        float er = 0.5f * (z[2 * n] + z[2 * m]);
+        float ei = 0.5f * (z[2 * n + 1] - z[2 * m + 1]);
+        float or_ = 0.5f * (z[2 * n + 1] + z[2 * m + 1]);
+        float oi = -0.5f * (z[2 * n] - z[2 * m]);
+        float xr = er + or_ * t.twiddleRe[k] - oi * t.twiddleIm[k];
+        float xi = ei + or_ * t.twiddleIm[k] + oi * t.twiddleRe[k];
+        float power = (xr * xr + xi * xi) * ((k == 0 || k == M) ? 1.0f : 2.0f);
+        for(uint8_t i = 0; i < this->bandCount; i++){
+            if(k >= this->bandLow[i] && k <= this->bandHigh[i]) this->energy[i] += power;
+        }
+    }
+
+    void finish(){
+        float scale = 1.0f / (N * table().windowPower);
+        for(uint8_t i = 0; i < this->bandCount; i++) this->result[i] = this->energy[i] * scale;
+        this->finished++;
+        this->phase = idle;
+    }
+
+    /*FRAMES*/
+    float buffers[2][N];
+    float* fill;
+    float* work;
+    uint16_t position;
+    uint32_t reference;
+
+    /*TRANSFORM STATE*/
+    phase_t phase;
+    uint16_t half;
+    uint16_t unit;
+    uint32_t finished;
+
+    /*BANDS*/
+    uint32_t sampleMilliHz;
+    uint8_t bandCount;
+    uint16_t bandLow[BMP_SPECTRUM_MAX_BANDS];
+    uint16_t bandHigh[BMP_SPECTRUM_MAX_BANDS];
+    float energy[BMP_SPECTRUM_MAX_BANDS];
+    float result[BMP_SPECTRUM_MAX_BANDS];
+};
+
+#endif
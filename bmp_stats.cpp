@@ -0,0 +1,216 @@
+/**
+ * @file bmp_stats.cpp
+ * @author Denys Khmil
+ * @brief This file contents the running noise statistics functions
+ */
+#include "bmp_stats.h"
+#include <math.h>
+
+/**
+ * @brief Empty statistics
+ */
+bmp_running_stats::bmp_running_stats(){
+    this->reset();
+}
+
+
+/**
+ * @brief Forget all values
+ */
+void bmp_running_stats::reset(){
+    this->n = 0;
+    this->first = 0;
+    this->sum = 0;
+    this->squares = 0;
+    this->squaresHigh = 0;
+    this->minimum = INT32_MAX;
+    this->maximum = INT32_MIN;
+}
+
+
+/**
+ * @brief Add value in O(1)
+ */
+void bmp_running_stats::add(int32_t value){
+    if(!this->n) this->first = value;
+    this->n++;
+    int64_t offset = (int64_t)value - this->first;
+    this->sum += offset;
+    uint64_t square = (uint64_t)(offset < 0 ? -offset : offset);
+    square *= square;
+    this->squares += square;
+    if(this->squares < square) this->squaresHigh++;
+    if(value < this->minimum) this->minimum = value;
+    if(value > this->maximum) this->maximum = value;
+}
+
+
+/**
+ * @brief Number of values
+ */
+uint32_t bmp_running_stats::count() const{
+    return this->n;
+}
+
+
+/**
+ * @brief Mean of values
+ */
+double bmp_running_stats::mean() const{
+    return this->n ? ((double)this->first * this->n + (double)this->sum) / this->n : 0.0;
+}
+
+
+/**
+ * @brief Sample variance of values (0 for less than 2 values)
+ */
+double bmp_running_stats::variance() const{
+    if(this->n < 2) return 0.0;
+    double squares = (double)this->squaresHigh * 18446744073709551616.0 + (double)this->squares;
+    double m2 = squares - (double)this->sum * (double)this->sum / this->n;
+    return (m2 > 0.0) ? m2 / (this->n - 1) : 0.0;
+}
+
+
+/**
+ * @brief Sample standard deviation of values
+ */
+double bmp_running_stats::stddev() const{
+    return sqrt(this->variance());
+}
+
+
+/**
+ * @brief Smallest value (INT32_MAX when empty)
+ */
+int32_t bmp_running_stats::min() const{
+    return this->minimum;
+}
+
+
+/**
+ * @brief Largest value (INT32_MIN when empty)
+ */
+int32_t bmp_running_stats::max() const{
+    return this->maximum;
+}
+
+
+/**
+ * @brief bmp_stats constructor with tumbling window
+ * @param _window: samples per window.
+ */
+bmp_stats::bmp_stats(uint32_t _window){
+    this->window = _window;
+    this->completed = 0;
+}
+
+
+/**
+ * @brief bmp_stats constructor without window
+ */
+bmp_stats::bmp_stats() : bmp_stats(0){
+}
+
+
+/**
+ * @brief Add compensated sample
+ * @note Completing a window moves it to last() and starts a new one
+ */
+void bmp_stats::add(const bmp_sample* sample){
+    this->currentT.add(sample->temperature);
+    this->currentP.add((int32_t)sample->pressure);
+    this->currentH.add((int32_t)sample->humidity);
+
+    if(this->window && this->currentP.count() >= this->window){
+        this->lastT = this->currentT;
+        this->lastP = this->currentP;
+        this->lastH = this->currentH;
+        this->currentT.reset();
+        this->currentP.reset();
+        this->currentH.reset();
+        this->completed++;
+    }
+}
+
+
+/**
+ * @brief Change window length, restarts the running window
+ * @param _window: samples per window (0 = no window).
+ */
+void bmp_stats::setWindow(uint32_t _window){
+    this->window = _window;
+    this->currentT.reset();
+    this->currentP.reset();
+    this->currentH.reset();
+}
+
+
+/**
+ * @brief Forget running and completed windows
+ */
+void bmp_stats::reset(){
+    this->currentT.reset();
+    this->currentP.reset();
+    this->currentH.reset();
+    this->lastT.reset();
+    this->lastP.reset();
+    this->lastH.reset();
+    this->completed = 0;
+}
+
+
+/**
+ * @brief Running window temperature statistics (0.01 degC)
+ */
+const bmp_running_stats& bmp_stats::temperature() const{
+    return this->currentT;
+}
+
+
+/**
+ * @brief Running window pressure statistics (Q24.8 Pa)
+ */
+const bmp_running_stats& bmp_stats::pressure() const{
+    return this->currentP;
+}
+
+
+/**
+ * @brief Running window humidity statistics (Q22.10 %RH)
+ */
+const bmp_running_stats& bmp_stats::humidity() const{
+    return this->currentH;
+}
+
+
+/**
+ * @brief Last completed window temperature statistics (0.01 degC)
+ */
+const bmp_running_stats& bmp_stats::lastTemperature() const{
+    return this->lastT;
+}
+
+
+/**
+ * @brief Last completed window pressure statistics (Q24.8 Pa)
+ */
+const bmp_running_stats& bmp_stats::lastPressure() const{
+    return this->lastP;
+}
+
+
+/**
+ * @brief Last completed window humidity statistics (Q22.10 %RH)
+ */
+const bmp_running_stats& bmp_stats::lastHumidity() const{
+    return this->lastH;
+}
+
+
+/**
+ * @brief Number of completed windows
+ */
+uint32_t bmp_stats::windows() const{
+    return this->completed;
+}
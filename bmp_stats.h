@@ -0,0 +1,82 @@
+/**
+ * @file bmp_stats.h
+ * @author Denys Khmil
+ * @brief This file contents the running noise statistics of compensated samples
+ */
+#ifndef BMP_STATS
+#define BMP_STATS
+
+#include <stdint.h>
+#include "bmp_sample.h"
+
+/**
+ * @brief Mean/variance with min/max of one channel, integer accumulation
+ * @note Values keep the units of the channel (e.g. Q24.8 Pa for pressure). add() sums the
+ *       offsets from the first value in 64 bit and their squares in 96 bit integers, no
+ *       floating point; mean() and variance() convert. Exact for any int32 values while
+ *       count * (largest offset) < 2^63
+ */
+class bmp_running_stats{
+public:
+    bmp_running_stats();
+    void reset();
+    void add(int32_t value);
+
+    uint32_t count() const;
+    double mean() const;
+    double variance() const;
+    double stddev() const;
+    int32_t min() const;
+    int32_t max() const;
+
+private:
+    uint32_t n;
+    int32_t first;
+    int64_t sum;
+    uint64_t squares;
+    uint32_t squaresHigh;
+    int32_t minimum;
+    int32_t maximum;
+};
+
+/**
+ * @brief Noise statistics of a sensor over tumbling windows
+ * @note current() is the running window, last() the last completed one.
+ *       Window 0 never completes (statistics since reset)
+ */
+class bmp_stats{
+public:
+    /*CONSTRUCTORS*/
+    bmp_stats(uint32_t _window);
+    bmp_stats();
+
+    /*UPDATE*/
+    void add(const bmp_sample* sample);
+    void setWindow(uint32_t _window);
+    void reset();
+
+    /*QUERIES*/
+    const bmp_running_stats& temperature() const;
+    const bmp_running_stats& pressure() const;
+    const bmp_running_stats& humidity() const;
+    const bmp_running_stats& lastTemperature() const;
+    const bmp_running_stats& lastPressure() const;
+    const bmp_running_stats& lastHumidity() const;
+    uint32_t windows() const;
+
+private:
+    uint32_t window;
+    uint32_t completed;
+
+    /*RUNNING WINDOW*/
+    bmp_running_stats currentT;
+    bmp_running_stats currentP;
+    bmp_running_stats currentH;
+
+    /*LAST COMPLETED WINDOW*/
+    bmp_running_stats lastT;
+    bmp_running_stats lastP;
+    bmp_running_stats lastH;
+};
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ * @file bmp_task.h
+ * @author Denys Khmil
+ * @brief This file contents the RTOS acquisition task with queue delivery
+ */
+#ifndef BMP_TASK
+#define BMP_TASK
+
+#include <stdint.h>
+#include <atomic>
+#include "bmp_sample.h"
+#include "bmp_os.h"
+#include "bmp_fanout.h"
+
+/*DEFAULTS*/
+#define BMP_TASK_BUS_TIMEOUT    10
+#define BMP_TASK_STACK_WORDS    256
+#define BMP_TASK_PRIORITY       2
+
+/**
+ * @brief Task reading a sensor on its own period and posting samples to subscriber queues
+ * @param Sensor: sensor with interrupt driven reads: startRead(), finishRead(bmp_raw*),
+ *        abortRead() and compensate() (bmp280 after setAsyncBus()).
+ * @note The task sleeps between periods and while the transfer runs: the application's
+ *       HAL_I2C_MemRxCpltCallback calls busComplete() and HAL_I2C_ErrorCallback calls busError()
+ *       (route by sensor.ownsBus(hi2c)). A transfer not completed in bus_timeout ms is aborted.
+ *       Subscribers are fed through bmp_fanout, each at its own ratio (decimated or averaged);
+ *       a full queue drops the sample for that subscriber only (counted in drops())
+ */
+template<typename Sensor, uint8_t MaxSubscribers = 4, uint16_t StackWords = BMP_TASK_STACK_WORDS>
+class bmp_task{
+    static_assert(MaxSubscribers <= BMP_FANOUT_MAX_SUBSCRIBERS, "too many subscribers for bmp_fanout");
+public:
+    /*CONSTRUCTORS*/
+    bmp_task(Sensor* _sensor, uint32_t _period, uint32_t _bus_timeout = BMP_TASK_BUS_TIMEOUT){
+        this->sensor = _sensor;
+        this->period = _period;
+        this->busTimeout = _bus_timeout;
+        this->running.store(0);
+        this->failed.store(0);
+        this->sampleCount.store(0);
+        this->errorCount.store(0);
+        this->timeoutCount.store(0);
+    }
+
+    /**
+     * @brief Add subscriber queue (before start())
+     * @param ratio: samples per posted sample (1 = every sample).
+     * @param mode: BMP_FANOUT_DECIMATE or BMP_FANOUT_AVERAGE.
+     * @retval Subscriber index, -1 if the table is full
+     */
+    int8_t subscribe(bmp_os_queue<bmp_sample>* queue, uint16_t ratio = 1, uint8_t mode = BMP_FANOUT_DECIMATE){
+        uint8_t index = this->fanout.count();
+        if(index >= MaxSubscribers || !queue) return -1;
+        subscriber_t& subscriber = this->subscribers[index];
+        subscriber.queue = queue;
+        subscriber.drops.store(0);
+        return this->fanout.subscribe(ratio, mode, post, &subscriber);
+    }
+
+    /**
+     * @brief Start acquisition task
+     * @retval 1 if the task was created
+     */
+    uint8_t start(const char* name = "bmp", uint8_t priority = BMP_TASK_PRIORITY){
+        this->running.store(1);
+        if(this->thread.start(entry, this, name, priority)) return 1;
+        this->running.store(0);
+        return 0;
+    }
+
+    /**
+     * @brief Stop after the current period and wait for the task to end
+     */
+    void stop(){
+        this->running.store(0);
+        this->thread.join();
+    }
+
+    /*BUS CALLBACKS (ISR)*/
+    void busComplete(){
+        this->done.giveFromISR();
+    }
+
+    void busError(){
+        this->failed.store(1);
+        this->done.giveFromISR();
+    }
+
+    /*COUNTERS*/
+    uint32_t samples() const{ return this->sampleCount.load(); }
+    uint32_t errors() const{ return this->errorCount.load(); }
+    uint32_t timeouts() const{ return this->timeoutCount.load(); }
+    uint32_t drops(uint8_t index) const{ return (index < this->fanout.count()) ? this->subscribers[index].drops.load() : 0; }
+
+private:
+    struct subscriber_t{
+        bmp_os_queue<bmp_sample>* queue;
+        std::atomic<uint32_t> drops;
+    };
+
+    static void post(const bmp_sample* sample, void* context){
+        subscriber_t* subscriber = (subscriber_t*)context;
+        if(!subscriber->queue->send(*sample)) subscriber->drops.fetch_add(1);
+    }
+
+    static void entry(void* self){
+        ((bmp_task*)self)->run();
+    }
+
+    void run(){
+        bmp_os_period timer;
+        timer.start();
+        while(this->running.load()){
+            timer.wait(this->period);
+            if(!this->running.load()) break;
+            this->acquire();
+        }
+    }
+
+    /**
+     * @brief One interrupt driven read, blocks only on the completion signal
+     */
+    void acquire(){
+        this->done.clear();
+        this->failed.store(0);
+        if(this->sensor->startRead() != 0){
+            this->errorCount.fetch_add(1);
+            return;
+        }
+        if(!this->done.take(this->busTimeout)){
+            this->sensor->abortRead();
+            this->timeoutCount.fetch_add(1);
+            return;
+        }
+        if(this->failed.load()){
+            this->errorCount.fetch_add(1);
+            return;
+        }
+        bmp_raw raw;
+        bmp_sample sample;
+        this->sensor->finishRead(&raw);
+        this->sensor->compensate(&raw, &sample);
+        this->sampleCount.fetch_add(1);
+        this->fanout.process(&sample);
+    }
+
+    Sensor* sensor;
+    uint32_t period;
+    uint32_t busTimeout;
+
+    /*SUBSCRIBERS*/
+    bmp_fanout fanout;
+    subscriber_t subscribers[MaxSubscribers];
+
+    /*TASK STATE*/
+    bmp_os_thread<StackWords> thread;
+    bmp_os_signal done;
+    std::atomic<uint8_t> running;
+    std::atomic<uint8_t> failed;
+
+    /*COUNTERS*/
+    std::atomic<uint32_t> sampleCount;
+    std::atomic<uint32_t> errorCount;
+    std::atomic<uint32_t> timeoutCount;
+};
+
+#endif
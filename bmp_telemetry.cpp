@@ -0,0 +1,275 @@
+/**
+ * @file bmp_telemetry.cpp
+ * @author Denys Khmil
+ * @brief This file contents the raw frame telemetry functions
+ */
+#include "bmp_telemetry.h"
+
+/**
+ * @brief CRC-16/CCITT
+ */
+static uint16_t crc16(const uint8_t* data, uint16_t length){
+    uint16_t value = 0xFFFF;
+    while(length--){
+        value ^= (uint16_t)(*data++ << 8);
+        for(uint8_t bit = 0; bit < 8; bit++) value = (value & 0x8000) ? (uint16_t)((value << 1) ^ 0x1021) : (uint16_t)(value << 1);
+    }
+    return value;
+}
+
+
+static void put16(uint8_t* data, uint16_t value){
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+}
+
+
+static uint16_t get16(const uint8_t* data){
+    return (uint16_t)(data[0]|(data[1] << 8));
+}
+
+
+/**
+ * @brief Encoder for one sensor session
+ * @param calib: calibration of the sensor (bmp280::getCalibration()).
+ * @param session: id of this power-up, e.g. a boot counter, so the ground notices a restart.
+ * @param frames_per_packet: 1..BMP_TELEMETRY_MAX_FRAMES, more frames amortize the 7 byte overhead.
+ */
+bmp_telemetry_encoder::bmp_telemetry_encoder(const bmp280_calib& calib, uint8_t session, uint8_t frames_per_packet){
+    this->calib = calib;
+    this->session = session;
+    if(frames_per_packet < 1) frames_per_packet = 1;
+    if(frames_per_packet > BMP_TELEMETRY_MAX_FRAMES) frames_per_packet = BMP_TELEMETRY_MAX_FRAMES;
+    this->framesPerPacket = frames_per_packet;
+    this->frameBytes = calib.humidity ? BMP_TELEMETRY_FRAME_H_SIZE : BMP_TELEMETRY_FRAME_SIZE;
+    this->nextSequence = 0;
+    this->pending = 0;
+}
+
+
+/**
+ * @brief Build calibration packet
+ * @param packet: BMP_TELEMETRY_CALIB_SIZE bytes.
+ * @retval Packet length
+ * @note Carries the sequence of the next data packet's first frame, pending frames are not affected
+ */
+uint16_t bmp_telemetry_encoder::calibration(uint8_t* packet){
+    const uint16_t fields[12] = {this->calib.dig_T1, (uint16_t)this->calib.dig_T2, (uint16_t)this->calib.dig_T3,
+                                 this->calib.dig_P1, (uint16_t)this->calib.dig_P2, (uint16_t)this->calib.dig_P3,
+                                 (uint16_t)this->calib.dig_P4, (uint16_t)this->calib.dig_P5, (uint16_t)this->calib.dig_P6,
+                                 (uint16_t)this->calib.dig_P7, (uint16_t)this->calib.dig_P8, (uint16_t)this->calib.dig_P9};
+    packet[0] = BMP_TELEMETRY_CALIB;
+    packet[1] = this->session;
+    put16(packet + 2, this->nextSequence);
+    packet[4] = this->calib.humidity;
+    for(uint8_t i = 0; i < 12; i++) put16(packet + 5 + 2 * i, fields[i]);
+    packet[29] = this->calib.dig_H1;
+    put16(packet + 30, (uint16_t)this->calib.dig_H2);
+    packet[32] = this->calib.dig_H3;
+    put16(packet + 33, (uint16_t)this->calib.dig_H4);
+    put16(packet + 35, (uint16_t)this->calib.dig_H5);
+    packet[37] = (uint8_t)this->calib.dig_H6;
+    put16(packet + 38, crc16(packet, 38));
+    return BMP_TELEMETRY_CALIB_SIZE;
+}
+
+
+/**
+ * @brief Append raw frame (bmp280::readRaw())
+ * @retval Length of the completed data packet in packet(), 0 while the packet is filling
+ */
+uint16_t bmp_telemetry_encoder::add(const bmp_raw* raw){
+    uint8_t* frame = this->buffer + BMP_TELEMETRY_HEADER_SIZE + this->pending * this->frameBytes;
+    uint64_t bits = ((uint64_t)(raw->temperature & 0xFFFFF) << 20)|(uint64_t)(raw->pressure & 0xFFFFF);
+    for(uint8_t i = 0; i < 5; i++) frame[i] = (uint8_t)(bits >> (8 * i));
+    if(this->calib.humidity) put16(frame + 5, (uint16_t)raw->humidity);
+    if(++this->pending < this->framesPerPacket) return 0;
+    return this->finish();
+}
+
+
+/**
+ * @brief Close partially filled packet
+ * @retval Length of the data packet in packet(), 0 without pending frames
+ */
+uint16_t bmp_telemetry_encoder::flush(){
+    return this->pending ? this->finish() : 0;
+}
+
+
+/**
+ * @brief Last completed data packet, valid until the next add()
+ */
+const uint8_t* bmp_telemetry_encoder::packet() const{
+    return this->buffer;
+}
+
+
+/**
+ * @brief Sequence number of the next packet's first frame
+ */
+uint16_t bmp_telemetry_encoder::sequence() const{
+    return this->nextSequence;
+}
+
+
+/**
+ * @brief Bytes per frame on the link
+ */
+uint8_t bmp_telemetry_encoder::frameSize() const{
+    return this->frameBytes;
+}
+
+
+/**
+ * @brief Write header and CRC of pending frames
+ */
+uint16_t bmp_telemetry_encoder::finish(){
+    uint16_t length = BMP_TELEMETRY_HEADER_SIZE + this->pending * this->frameBytes;
+    this->buffer[0] = BMP_TELEMETRY_DATA;
+    this->buffer[1] = this->session;
+    put16(this->buffer + 2, this->nextSequence);
+    this->buffer[4] = this->pending;
+    put16(this->buffer + length, crc16(this->buffer, length));
+    this->nextSequence += this->pending;
+    this->pending = 0;
+    return length + BMP_TELEMETRY_CRC_SIZE;
+}
+
+
+/**
+ * @brief Decoder waiting for a calibration packet
+ * @param sink: called with every decoded frame.
+ */
+bmp_telemetry_decoder::bmp_telemetry_decoder(bmp_telemetry_sink sink, void* context){
+    this->sink = sink;
+    this->context = context;
+    this->calib.humidity = 0;
+    this->calibrated = 0;
+    this->currentSession = 0;
+    this->expected = 0;
+    this->frameCount = 0;
+    this->lostCount = 0;
+    this->rejectedCount = 0;
+    this->lateCount = 0;
+}
+
+
+/**
+ * @brief Process one received packet
+ * @retval Frames delivered to the sink, 0 for a calibration packet, -1 if the packet was rejected
+ *         (length, CRC, unknown session or a late packet)
+ * @note A calibration packet resynchronizes the sequence. So does the BMP_TELEMETRY_RESYNC_LATE-th
+ *       late packet in a row, which is taken as a dropout of more than 32768 frames
+ */
+int8_t bmp_telemetry_decoder::receive(const uint8_t* packet, uint16_t length){
+    if(length < BMP_TELEMETRY_HEADER_SIZE + BMP_TELEMETRY_CRC_SIZE || get16(packet + length - 2) != crc16(packet, length - 2)){
+        this->rejectedCount++;
+        return -1;
+    }
+
+    if(packet[0] == BMP_TELEMETRY_CALIB && length == BMP_TELEMETRY_CALIB_SIZE){
+        this->calib.dig_T1 = get16(packet + 5);
+        this->calib.dig_T2 = (int16_t)get16(packet + 7);
+        this->calib.dig_T3 = (int16_t)get16(packet + 9);
+        this->calib.dig_P1 = get16(packet + 11);
+        this->calib.dig_P2 = (int16_t)get16(packet + 13);
+        this->calib.dig_P3 = (int16_t)get16(packet + 15);
+        this->calib.dig_P4 = (int16_t)get16(packet + 17);
+        this->calib.dig_P5 = (int16_t)get16(packet + 19);
+        this->calib.dig_P6 = (int16_t)get16(packet + 21);
+        this->calib.dig_P7 = (int16_t)get16(packet + 23);
+        this->calib.dig_P8 = (int16_t)get16(packet + 25);
+        this->calib.dig_P9 = (int16_t)get16(packet + 27);
+        this->calib.humidity = packet[4];
+        this->calib.dig_H1 = packet[29];
+        this->calib.dig_H2 = (int16_t)get16(packet + 30);
+        this->calib.dig_H3 = packet[32];
+        this->calib.dig_H4 = (int16_t)get16(packet + 33);
+        this->calib.dig_H5 = (int16_t)get16(packet + 35);
+        this->calib.dig_H6 = (int8_t)packet[37];
+        this->calib.t_fine = 0;
+        /*a repeated calibration of the running session counts the frames missed before it*/
+        uint16_t sequence = get16(packet + 2);
+        uint16_t gap = (uint16_t)(sequence - this->expected);
+        if(this->calibrated && packet[1] == this->currentSession && gap < 0x8000) this->lostCount += gap;
+        this->expected = sequence;
+        this->lateCount = 0;
+        this->currentSession = packet[1];
+        this->calibrated = 1;
+        return 0;
+    }
+
+    uint8_t frame_bytes = this->calib.humidity ? BMP_TELEMETRY_FRAME_H_SIZE : BMP_TELEMETRY_FRAME_SIZE;
+    uint8_t count = packet[4];
+    if(packet[0] != BMP_TELEMETRY_DATA || !this->calibrated || packet[1] != this->currentSession
+       || count > BMP_TELEMETRY_MAX_FRAMES
+       || length != BMP_TELEMETRY_HEADER_SIZE + count * frame_bytes + BMP_TELEMETRY_CRC_SIZE){
+        this->rejectedCount++;
+        return -1;
+    }
+    uint16_t sequence = get16(packet + 2);
+    uint16_t gap = (uint16_t)(sequence - this->expected);
+    if(gap >= 0x8000 && ++this->lateCount < BMP_TELEMETRY_RESYNC_LATE){
+        this->rejectedCount++;
+        return -1;
+    }
+    if(gap < 0x8000) this->lostCount += gap;
+    this->lateCount = 0;
+    this->expected = (uint16_t)(sequence + count);
+
+    const uint8_t* frame = packet + BMP_TELEMETRY_HEADER_SIZE;
+    for(uint8_t i = 0; i < count; i++, frame += frame_bytes){
+        uint64_t bits = 0;
+        for(uint8_t b = 0; b < 5; b++) bits |= (uint64_t)frame[b] << (8 * b);
+        bmp_raw raw;
+        bmp_sample sample;
+        raw.temperature = (int32_t)((bits >> 20) & 0xFFFFF);
+        raw.pressure = (int32_t)(bits & 0xFFFFF);
+        raw.humidity = this->calib.humidity ? get16(frame + 5) : 0;
+        bmp280_compensate(&this->calib, &raw, &sample);
+        if(this->sink) this->sink((uint16_t)(sequence + i), &sample, this->context);
+    }
+    this->frameCount += count;
+    return (int8_t)count;
+}
+
+
+/**
+ * @brief Calibration packet received
+ */
+uint8_t bmp_telemetry_decoder::hasCalibration() const{
+    return this->calibrated;
+}
+
+
+/**
+ * @brief Session of the last calibration packet
+ */
+uint8_t bmp_telemetry_decoder::session() const{
+    return this->currentSession;
+}
+
+
+/**
+ * @brief Frames delivered to the sink
+ */
+uint32_t bmp_telemetry_decoder::frames() const{
+    return this->frameCount;
+}
+
+
+/**
+ * @brief Frames missing from sequence gaps
+ */
+uint32_t bmp_telemetry_decoder::lost() const{
+    return this->lostCount;
+}
+
+
+/**
+ * @brief Packets dropped by length, CRC, session or order checks
+ */
+uint32_t bmp_telemetry_decoder::rejected() const{
+    return this->rejectedCount;
+}
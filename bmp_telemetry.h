@@ -0,0 +1,102 @@
+/**
+ * @file bmp_telemetry.h
+ * @author Denys Khmil
+ * @brief This file contents the raw frame telemetry encoder and the ground decoder
+ */
+#ifndef BMP_TELEMETRY
+#define BMP_TELEMETRY
+
+#include <stdint.h>
+#include "bmp_sample.h"
+#include "bmp280_compensate.h"
+
+/*PACKET TYPES*/
+#define BMP_TELEMETRY_CALIB         0xC5
+#define BMP_TELEMETRY_DATA          0xD5
+
+/*PACKET LAYOUT*/
+#define BMP_TELEMETRY_HEADER_SIZE   5
+#define BMP_TELEMETRY_CRC_SIZE      2
+#define BMP_TELEMETRY_CALIB_SIZE    40
+#define BMP_TELEMETRY_FRAME_SIZE    5
+#define BMP_TELEMETRY_FRAME_H_SIZE  7
+#define BMP_TELEMETRY_MAX_FRAMES    32
+#define BMP_TELEMETRY_MAX_SIZE      (BMP_TELEMETRY_HEADER_SIZE + BMP_TELEMETRY_MAX_FRAMES * BMP_TELEMETRY_FRAME_H_SIZE + BMP_TELEMETRY_CRC_SIZE)
+
+/*DECODER*/
+#define BMP_TELEMETRY_RESYNC_LATE   4
+
+/**
+ * @brief Decoded sample sink, called in the context of receive()
+ * @param sequence: frame sequence number, gaps are lost frames.
+ */
+typedef void (*bmp_telemetry_sink)(uint16_t sequence, const bmp_sample* sample, void* context);
+
+/**
+ * @brief Packs raw frames into telemetry packets
+ * @note The calibration packet is sent once per session (and again whenever the ground asks),
+ *       data packets then carry only the 20-bit temperature and pressure adc values, 5 bytes
+ *       per frame (7 with BME280 humidity), instead of 16 bytes of doubles.
+ *       Packets: type, session, sequence of the first frame (16 bit), frame count, frames,
+ *       CRC-16/CCITT. Multi-byte fields are little-endian
+ */
+class bmp_telemetry_encoder{
+public:
+    /*CONSTRUCTORS*/
+    bmp_telemetry_encoder(const bmp280_calib& calib, uint8_t session, uint8_t frames_per_packet = 1);
+
+    /*PACKETS*/
+    uint16_t calibration(uint8_t* packet);
+    uint16_t add(const bmp_raw* raw);
+    uint16_t flush();
+    const uint8_t* packet() const;
+
+    /*QUERIES*/
+    uint16_t sequence() const;
+    uint8_t frameSize() const;
+
+private:
+    uint16_t finish();
+
+    bmp280_calib calib;
+    uint8_t session;
+    uint8_t framesPerPacket;
+    uint8_t frameBytes;
+    uint16_t nextSequence;
+    uint8_t pending;
+    uint8_t buffer[BMP_TELEMETRY_MAX_SIZE];
+};
+
+/**
+ * @brief Checks and unpacks telemetry packets, compensates frames bit-exactly with bmp280_compensate
+ * @note Data packets are dropped until the calibration packet of their session has arrived
+ */
+class bmp_telemetry_decoder{
+public:
+    /*CONSTRUCTORS*/
+    bmp_telemetry_decoder(bmp_telemetry_sink sink, void* context = 0);
+
+    /*PACKETS*/
+    int8_t receive(const uint8_t* packet, uint16_t length);
+
+    /*QUERIES*/
+    uint8_t hasCalibration() const;
+    uint8_t session() const;
+    uint32_t frames() const;
+    uint32_t lost() const;
+    uint32_t rejected() const;
+
+private:
+    bmp_telemetry_sink sink;
+    void* context;
+    bmp280_calib calib;
+    uint8_t calibrated;
+    uint8_t currentSession;
+    uint16_t expected;
+    uint32_t frameCount;
+    uint32_t lostCount;
+    uint32_t rejectedCount;
+    uint8_t lateCount;
+};
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file bench.h
+ * @author Denys Khmil
+ * @brief Timing helpers for the host benchmarks
+ */
+#ifndef BMP_BENCH
+#define BMP_BENCH
+
+#include <stdint.h>
+#include <chrono>
+
+#define BENCH_REPEATS 5
+
+/**
+ * @brief Best of BENCH_REPEATS runs of body(iterations)
+ * @retval Nanoseconds per iteration
+ */
+template<typename Body>
+static double benchBest(uint64_t iterations, Body body){
+    double best = 0.0;
+    for(int r = 0; r < BENCH_REPEATS; r++){
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+        if(r == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+/**
+ * @brief Keep a result alive without a store the compiler can drop
+ */
+template<typename T>
+static inline void benchKeep(const T& value){
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif
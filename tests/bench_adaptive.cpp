@@ -0,0 +1,189 @@
+/**
+ * @file bench_adaptive.cpp
+ * @author Denys Khmil
+ * @brief Host benchmark: bmp280_adaptive replaying pressure traces on a stub sensor
+ *
+ * Trace of 100 s flat, 100 s climb at -36 Pa/s and 200 s flat with 1.5 Pa noise. Checks that
+ * the controller reaches the fastest preset early in the climb and the low-power one soon after
+ * it, one switch per step, that a slope between the down and up thresholds never switches and
+ * that noise alone never steps up. Prints the energy/latency report against each preset held fixed.
+ */
+#include <stdio.h>
+
+#include "bmp280_adaptive.h"
+#include "test.h"
+
+#define TRACE_FLAT_MS       100000
+#define TRACE_CLIMB_MS      100000
+#define TRACE_END_MS        400000
+#define TRACE_CLIMB_RATE    (-36 * 256)
+#define TRACE_NOISE         384
+#define TRACE_BASE          (95000 * 256)
+
+/*lowest power to most responsive: osrs_p, osrs_t, filter, t_sb*/
+static const bmp280_preset presets[3] = {
+    {0b011, 0b001, 4, 0b101, 0},
+    {0b011, 0b001, 2, 0b011, 0},
+    {0b010, 0b001, 1, 0b001, 0},
+};
+static const uint32_t upRate = 10 * 256;
+static const uint32_t downRate = 5 * 256;
+static const uint16_t hold = 3;
+
+/**
+ * @brief Sensor that only counts the configuration writes
+ */
+struct stub_sensor{
+    stub_sensor(){
+        this->configs = 0;
+        this->settingsCalls = 0;
+    }
+    void settings(uint8_t, uint8_t, uint8_t){ this->settingsCalls++; }
+    void setConfig(uint8_t, uint8_t){ this->configs++; }
+
+    uint32_t configs;
+    uint32_t settingsCalls;
+};
+
+typedef bmp280_adaptive<stub_sensor, 3> controller;
+
+/**
+ * @brief Pressure trace (Q24.8 Pa) with noise of about noise LSB rms
+ */
+struct trace{
+    trace(uint32_t _climb_from, uint32_t _climb_to, int32_t _climb_rate, int32_t _noise){
+        this->climbFrom = _climb_from;
+        this->climbTo = _climb_to;
+        this->climbRate = _climb_rate;
+        this->noise = _noise;
+        this->seed = 1;
+    }
+
+    uint32_t at(uint32_t ms){
+        int64_t pressure = TRACE_BASE;
+        if(ms > this->climbFrom){
+            uint32_t climbing = ((ms < this->climbTo) ? ms : this->climbTo) - this->climbFrom;
+            pressure += (int64_t)this->climbRate * climbing / 1000;
+        }
+        /*sum of four uniforms, rms of each is range / sqrt(12)*/
+        int32_t sum = 0;
+        for(int i = 0; i < 4; i++){
+            this->seed = this->seed * 1103515245 + 12345;
+            sum += (int32_t)((this->seed >> 8) % 1001) - 500;
+        }
+        return (uint32_t)(pressure + (int64_t)sum * this->noise * 173 / 100000);
+    }
+
+    uint32_t climbFrom;
+    uint32_t climbTo;
+    int32_t climbRate;
+    int32_t noise;
+    uint32_t seed;
+};
+
+/**
+ * @brief Switch times of a replay
+ */
+struct replay{
+    uint32_t switches;
+    uint32_t firstUp;
+    uint32_t top;
+    uint32_t bottom;
+};
+
+
+/**
+ * @brief Feed the trace at the sample period of the active preset
+ * @param table: presets the controller was built with.
+ */
+static replay run(controller& adaptive, trace& source, const bmp280_preset* table, uint8_t count){
+    replay result = {0, 0, 0, 0};
+    uint32_t now = 0;
+    uint8_t active = adaptive.active();
+    while(now < TRACE_END_MS){
+        const bmp280_preset& preset = table[active];
+        now += bmp280_samplePeriod(preset.osrs_p, preset.osrs_t, preset.t_sb) / 1000;
+        bmp_sample sample = {2000, source.at(now), 0};
+        uint8_t next = adaptive.update(&sample);
+        if(next == active) continue;
+        CHECK(next == active + 1 || next + 1 == active);
+        result.switches++;
+        if(next > active && !result.firstUp) result.firstUp = now;
+        if(next == count - 1) result.top = now;
+        if(next == 0) result.bottom = now;
+        active = next;
+    }
+    return result;
+}
+
+
+/**
+ * @brief Print the report of a run
+ */
+static void print(const char* name, const bmp280_adaptive_report& report){
+    printf("bench_adaptive: %-10s %7.2f uA  %2u switches  %6.1f mJ  dynamic latency %5u ms over %u samples\n",
+           name, report.averageCurrent() / 1000.0, report.switches,
+           report.charge_nams * 3.3 / 1e9, report.dynamicLatency(), report.dynamic_samples);
+}
+
+
+int main(){
+    /*flat, climb, flat*/
+    {
+        stub_sensor sensor;
+        controller adaptive(&sensor, presets, 3, upRate, downRate, hold);
+        adaptive.start(0);
+        trace source(TRACE_FLAT_MS, TRACE_FLAT_MS + TRACE_CLIMB_MS, TRACE_CLIMB_RATE, TRACE_NOISE);
+        replay result = run(adaptive, source, presets, 3);
+        printf("bench_adaptive: up at %u ms, fastest at %u ms, low power again at %u ms\n", result.firstUp, result.top, result.bottom);
+        CHECK(result.firstUp > TRACE_FLAT_MS);
+        CHECK(result.top > TRACE_FLAT_MS && result.top - TRACE_FLAT_MS <= 10000);
+        CHECK(result.bottom > TRACE_FLAT_MS + TRACE_CLIMB_MS && result.bottom - TRACE_FLAT_MS - TRACE_CLIMB_MS <= 30000);
+        CHECK_EQ(result.switches, 4);
+        CHECK_EQ(adaptive.report().switches, 4);
+        CHECK_EQ(adaptive.active(), 0);
+        CHECK_EQ(sensor.configs, 1 + 4);
+        CHECK_EQ(sensor.settingsCalls, 1 + 4);
+        print("adaptive", adaptive.report());
+
+        /*each preset held fixed over the same trace*/
+        bmp280_adaptive_report fixed[3];
+        for(uint8_t i = 0; i < 3; i++){
+            controller single(&sensor, &presets[i], 1, upRate, downRate, hold);
+            trace same(TRACE_FLAT_MS, TRACE_FLAT_MS + TRACE_CLIMB_MS, TRACE_CLIMB_RATE, TRACE_NOISE);
+            CHECK_EQ(run(single, same, &presets[i], 1).switches, 0);
+            fixed[i] = single.report();
+            char name[16];
+            snprintf(name, sizeof(name), "preset %u", i);
+            print(name, fixed[i]);
+        }
+        CHECK(adaptive.report().averageCurrent() < fixed[2].averageCurrent() / 2);
+        CHECK(adaptive.report().dynamicLatency() < fixed[0].dynamicLatency());
+    }
+
+    /*inside the hysteresis band: a steady 7 Pa/s slope never switches, four times the noise
+      without a slope never steps up*/
+    {
+        const int32_t rates[2] = {7 * 256, 0};
+        const int32_t noises[2] = {TRACE_NOISE, 4 * TRACE_NOISE};
+        for(int i = 0; i < 2; i++){
+            for(uint8_t preset = 0; preset < 3; preset++){
+                stub_sensor sensor;
+                controller adaptive(&sensor, presets, 3, upRate, downRate, hold);
+                adaptive.start(preset);
+                trace source(0, TRACE_END_MS, rates[i], noises[i]);
+                replay result = run(adaptive, source, presets, 3);
+                if(i == 1 && preset > 0){
+                    CHECK_EQ(adaptive.active(), 0);
+                    CHECK_EQ(result.switches, preset);
+                    CHECK_EQ(result.firstUp, 0);
+                }
+                else{
+                    CHECK_EQ(result.switches, 0);
+                }
+            }
+        }
+    }
+
+    return testResult("bench_adaptive");
+}
@@ -0,0 +1,117 @@
+/**
+ * @file bench_bus.cpp
+ * @author Denys Khmil
+ * @brief Host benchmark: bus limited sample rate of bmp280/BME280 at 100k, 400k, 1M and 3.4M
+ *
+ * Prints bmp280::maxSampleRate() per bus clock with and without humidity, checks that the HS
+ * master code is counted (and the hook called) only above 1 MHz, and times the driver's
+ * readRaw() + compensate() on a simulated bus for comparison.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "bmp280_lib.h"
+#include "hal_sim.h"
+#include "bench.h"
+#include "test.h"
+
+static const uint8_t calibration[24] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17
+};
+static const uint8_t humidityCalibration[7] = {0x6A, 0x01, 0x00, 0x13, 0x2C, 0x03, 0x1E};
+static const uint32_t clocks[4] = {100000, 400000, 1000000, 3400000};
+
+/**
+ * @brief Register file of a bmp280 or BME280 with a fixed measurement
+ */
+class sim_bmp280 : public hal_sim_device{
+public:
+    sim_bmp280(uint8_t chip_id){
+        memset(this->regs, 0, sizeof(this->regs));
+        this->regs[0xD0] = chip_id;
+        memcpy(&this->regs[0x88], calibration, sizeof(calibration));
+        this->regs[0xA1] = 75;
+        memcpy(&this->regs[0xE1], humidityCalibration, sizeof(humidityCalibration));
+        const uint8_t data[8] = {0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00, 0x6B, 0x5D};
+        memcpy(&this->regs[0xF7], data, sizeof(data));
+    }
+
+    HAL_StatusTypeDef read(uint8_t reg, uint8_t* data, uint16_t length){
+        for(uint16_t i = 0; i < length; i++) data[i] = this->regs[(uint8_t)(reg + i)];
+        return HAL_OK;
+    }
+
+    HAL_StatusTypeDef write(uint8_t reg, const uint8_t* data, uint16_t length){
+        for(uint16_t i = 0; i < length; i++) this->regs[(uint8_t)(reg + i)] = data[i];
+        return HAL_OK;
+    }
+
+private:
+    uint8_t regs[256];
+};
+
+static uint32_t hsEntries = 0;
+
+static void hsHook(I2C_HandleTypeDef*){
+    hsEntries++;
+}
+
+
+/**
+ * @brief Rate of the bare transfer model, master code added above 1 MHz only
+ */
+static uint32_t expectedRate(uint32_t clock, uint32_t bits){
+    uint64_t ns = (bits * 1000000000ULL) / clock;
+    if(clock > BMP280_I2C_FMP_CLOCK) ns += (BMP280_I2C_MASTER_CODE_BITS * 1000000000ULL) / BMP280_I2C_FM_CLOCK;
+    return (uint32_t)(1000000000ULL / ns);
+}
+
+
+int main(){
+    I2C_HandleTypeDef i2c;
+    hal_sim_bus bus;
+    sim_bmp280 bmp(BMP280_CHIP_ID);
+    sim_bmp280 bme(BME280_CHIP_ID);
+    hal_sim_attach(&i2c, &bus);
+    hal_sim_connect(&bus, BMP280_ADDRESS_PRIMARY, &bmp);
+    hal_sim_connect(&bus, BMP280_ADDRESS_SECONDARY, &bme);
+    bmp280 sensors[2] = {bmp280(i2c, BMP280_ADDRESS_PRIMARY), bmp280(i2c, BMP280_ADDRESS_SECONDARY)};
+    CHECK(!sensors[0].hasHumidity());
+    CHECK(sensors[1].hasHumidity());
+
+    printf("bench_bus: clock\tbmp280 samples/s\tBME280 samples/s\n");
+    for(uint32_t clock : clocks){
+        uint32_t rate = bmp280::maxSampleRate(clock);
+        uint32_t rate_h = bmp280::maxSampleRate(clock, 1);
+        printf("bench_bus: %7u\t%u\t%u\n", clock, rate, rate_h);
+        CHECK_EQ(rate, expectedRate(clock, BMP280_I2C_READRAW_BITS));
+        CHECK_EQ(rate_h, expectedRate(clock, BME280_I2C_READRAW_BITS));
+        CHECK(rate_h < rate);
+        for(bmp280& sensor : sensors){
+            sensor.setBusClock(clock, hsHook);
+            CHECK_EQ(sensor.maxSampleRate(), sensor.hasHumidity() ? rate_h : rate);
+            bmp_raw raw;
+            uint32_t entries = hsEntries;
+            CHECK_EQ(sensor.readRaw(&raw), HAL_OK);
+            CHECK_EQ(hsEntries - entries, (clock > BMP280_I2C_FMP_CLOCK) ? 1 : 0);
+        }
+    }
+
+    /*the master code is only sent above 1 MHz: 1 MHz itself is Fm+*/
+    CHECK_EQ(bmp280::maxSampleRate(BMP280_I2C_FMP_CLOCK), 1000000000ULL / ((BMP280_I2C_READRAW_BITS * 1000000000ULL) / BMP280_I2C_FMP_CLOCK));
+    CHECK(bmp280::maxSampleRate(BMP280_I2C_FMP_CLOCK + 1) < bmp280::maxSampleRate(BMP280_I2C_FMP_CLOCK));
+    CHECK(bmp280::maxSampleRate(3400000) < 3400000 / BMP280_I2C_READRAW_BITS);
+    CHECK_EQ(bmp280::maxSampleRate(0), 0);
+
+    /*driver cost per sample on the host, transfers of the simulated bus complete at once*/
+    for(bmp280& sensor : sensors){
+        double ns = benchBest(200000, [&](uint64_t n){
+            bmp_sample sample;
+            for(uint64_t i = 0; i < n; i++) sensor.getSample(&sample);
+            benchKeep(sample);
+        });
+        printf("bench_bus: %s readRaw + compensate %.1f ns/sample on the host\n", sensor.hasHumidity() ? "BME280" : "bmp280", ns);
+    }
+    return testResult("bench_bus");
+}
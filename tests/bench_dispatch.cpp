@@ -0,0 +1,137 @@
+/**
+ * @file bench_dispatch.cpp
+ * @author Denys Khmil
+ * @brief Host benchmark: bmp_sensor template dispatch against a virtual sensor interface
+ *
+ * Both loops read and compensate samples from the same simulated sensor. Code size is read from
+ * the symbol table of this binary (nm): the template loop has everything inlined, the virtual
+ * one also needs the out-of-line readRaw()/compensate() overrides and the vtable.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bmp_sensor.h"
+#include "bench.h"
+
+/**
+ * @brief Simulated sensor with a cheap linear compensation, so the call overhead dominates
+ */
+struct host_sensor{
+    uint32_t n;
+
+    int readRaw(bmp_raw* raw){
+        raw->temperature = 519888 + (int32_t)(this->n & 15);
+        raw->pressure = 415148 + (int32_t)((this->n * 7) & 63);
+        raw->humidity = 0;
+        this->n++;
+        return 0;
+    }
+
+    void compensate(const bmp_raw* raw, bmp_sample* sample){
+        sample->temperature = raw->temperature / 200;
+        sample->pressure = (uint32_t)raw->pressure * 62;
+        sample->humidity = 0;
+    }
+
+    void settings(uint8_t, uint8_t, uint8_t){}
+
+    int getStatus(){
+        return 0;
+    }
+};
+
+/**
+ * @brief The same interface as an abstract class
+ */
+class virtual_sensor{
+public:
+    virtual ~virtual_sensor(){}
+    virtual int readRaw(bmp_raw* raw) = 0;
+    virtual void compensate(const bmp_raw* raw, bmp_sample* sample) = 0;
+};
+
+class virtual_host_sensor : public virtual_sensor{
+public:
+    int readRaw(bmp_raw* raw){ return this->sensor.readRaw(raw); }
+    void compensate(const bmp_raw* raw, bmp_sample* sample){ this->sensor.compensate(raw, sample); }
+    host_sensor sensor;
+};
+
+__attribute__((noinline)) static uint64_t acquireTemplate(host_sensor& sensor, uint64_t count){
+    uint64_t sum = 0;
+    bmp_sample sample;
+    for(uint64_t i = 0; i < count; i++){
+        if(bmp_acquire(sensor, &sample)) sum += sample.pressure;
+    }
+    return sum;
+}
+
+__attribute__((noinline)) static uint64_t acquireVirtual(virtual_sensor& sensor, uint64_t count){
+    uint64_t sum = 0;
+    bmp_sample sample;
+    for(uint64_t i = 0; i < count; i++){
+        bmp_raw raw;
+        if(sensor.readRaw(&raw) != 0) continue;
+        sensor.compensate(&raw, &sample);
+        sum += sample.pressure;
+    }
+    return sum;
+}
+
+/**
+ * @brief Opaque to the optimizer, so the virtual calls are not devirtualized
+ */
+__attribute__((noinline)) static virtual_sensor* makeVirtual(){
+    static virtual_host_sensor sensor;
+    sensor.sensor.n = 0;
+    return &sensor;
+}
+
+
+/**
+ * @brief Bytes of the symbols of this binary whose demangled name starts with prefix
+ * @retval Size, 0 if nm is not available
+ */
+static unsigned long symbolSize(const char* binary, const char* prefix){
+    char command[512];
+    snprintf(command, sizeof(command), "nm -S -C '%s' 2>/dev/null", binary);
+    FILE* nm = popen(command, "r");
+    if(!nm) return 0;
+    unsigned long total = 0;
+    char line[512];
+    while(fgets(line, sizeof(line), nm)){
+        unsigned long address;
+        unsigned long size;
+        char type;
+        int name = 0;
+        if(sscanf(line, "%lx %lx %c %n", &address, &size, &type, &name) < 3 || !name) continue;
+        if(!strncmp(line + name, prefix, strlen(prefix))) total += size;
+    }
+    pclose(nm);
+    return total;
+}
+
+
+int main(int, char** argv){
+    const uint64_t samples = 50000000;
+    host_sensor sensor = {0};
+    virtual_sensor* dynamic = makeVirtual();
+    uint64_t a = 0;
+    uint64_t b = 0;
+    double template_ns = benchBest(samples, [&](uint64_t n){ sensor.n = 0; a = acquireTemplate(sensor, n); });
+    double virtual_ns = benchBest(samples, [&](uint64_t n){ static_cast<virtual_host_sensor*>(dynamic)->sensor.n = 0; b = acquireVirtual(*dynamic, n); });
+    printf("bench_dispatch: template %.2f ns/sample, virtual %.2f ns/sample (%s)\n",
+           template_ns, virtual_ns, (a == b) ? "same output" : "OUTPUT DIFFERS");
+
+    unsigned long template_size = symbolSize(argv[0], "acquireTemplate(");
+    unsigned long loop_size = symbolSize(argv[0], "acquireVirtual(");
+    unsigned long override_size = symbolSize(argv[0], "virtual_host_sensor::readRaw(") + symbolSize(argv[0], "virtual_host_sensor::compensate(");
+    unsigned long vtable_size = symbolSize(argv[0], "vtable for virtual_host_sensor");
+    if(template_size && loop_size){
+        printf("bench_dispatch: code template %lu bytes, virtual %lu bytes (loop %lu + overrides %lu + vtable %lu)\n",
+               template_size, loop_size + override_size + vtable_size, loop_size, override_size, vtable_size);
+    }
+    else printf("bench_dispatch: code size not reported, nm not found\n");
+    return (a == b) ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file bench_filter.cpp
+ * @author Denys Khmil
+ * @brief Host benchmark: time and TSC cycles per sample of the fixed-point filters
+ */
+#include <stdio.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "bmp_filter.h"
+#include "bench.h"
+
+/**
+ * @brief Cost per sample of Filter
+ */
+template<typename Filter>
+static void measure(const char* name){
+    const uint64_t samples = 50000000;
+    Filter filter;
+    int32_t y = 0;
+    double ns = benchBest(samples, [&](uint64_t n){
+        for(uint64_t i = 0; i < n; i++) y = filter.process(25600000 + (int32_t)(i & 255));
+        benchKeep(y);
+    });
+#if defined(__x86_64__) || defined(__i386__)
+    uint64_t start = __rdtsc();
+    for(uint64_t i = 0; i < samples; i++) y = filter.process(25600000 + (int32_t)(i & 255));
+    benchKeep(y);
+    double cycles = (double)(__rdtsc() - start) / samples;
+    printf("bench_filter: %s %.2f ns/sample, %.1f TSC cycles/sample\n", name, ns, cycles);
+#else
+    printf("bench_filter: %s %.2f ns/sample\n", name, ns);
+#endif
+}
+
+
+int main(){
+    measure<bmp_biquad<bmp_lowpass<2000, 100000> > >("biquad");
+    measure<bmp_butterworth4<2000, 100000> >("butterworth4");
+    return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file bench_median.cpp
+ * @author Denys Khmil
+ * @brief Host benchmark: streaming median throughput against sorting the window per sample
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "bmp_median.h"
+#include "bench.h"
+
+/**
+ * @brief Samples per second of bmp_median<N> and of a sorted copy of the window
+ */
+template<uint16_t N>
+static void measure(){
+    const uint64_t samples = 2000000;
+    std::vector<int32_t> input(samples);
+    srand(N);
+    for(uint64_t i = 0; i < samples; i++) input[i] = rand();
+
+    bmp_median<N> median;
+    double heap_ns = benchBest(samples, [&](uint64_t n){
+        int32_t y = 0;
+        for(uint64_t i = 0; i < n; i++) y = median.process(input[i]);
+        benchKeep(y);
+    });
+
+    int32_t ring[N];
+    std::vector<int32_t> window(N);
+    double sort_ns = benchBest(samples, [&](uint64_t n){
+        int32_t y = 0;
+        uint16_t count = 0;
+        for(uint64_t i = 0; i < n; i++){
+            ring[i % N] = input[i];
+            if(count < N) count++;
+            std::copy(ring, ring + count, window.begin());
+            std::sort(window.begin(), window.begin() + count);
+            y = window[count / 2];
+        }
+        benchKeep(y);
+    });
+    printf("bench_median: N=%u median %.1f ns (%.1f M/s), sort %.1f ns (%.1f M/s), %.1fx\n",
+           N, heap_ns, 1e3 / heap_ns, sort_ns, 1e3 / sort_ns, sort_ns / heap_ns);
+}
+
+
+int main(){
+    measure<9>();
+    measure<31>();
+    measure<127>();
+    return 0;
+}
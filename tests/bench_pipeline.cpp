@@ -0,0 +1,97 @@
+/**
+ * @file bench_pipeline.cpp
+ * @author Denys Khmil
+ * @brief Host benchmark: bmp_pipeline against the same stages written as one hand-rolled loop
+ *
+ * Chain: compensate, 4th order Butterworth, decimate by 4, publish. Both versions must produce
+ * the same output sum.
+ */
+#include <stdio.h>
+
+#include "bmp_pipeline.h"
+#include "bmp_filter.h"
+#include "bmp280_compensate.h"
+#include "bench.h"
+
+static const uint8_t calibration[BMP280_CALIB_LENGTH] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17
+};
+
+/**
+ * @brief Simulated bmp280 with the library compensation
+ */
+struct host_sensor{
+    bmp280_calib calib;
+    int32_t n;
+
+    int readRaw(bmp_raw* raw){
+        raw->temperature = 519888 + (this->n & 15);
+        raw->pressure = 415148 + ((this->n * 7) & 63);
+        raw->humidity = 0;
+        this->n++;
+        return 0;
+    }
+
+    void compensate(const bmp_raw* raw, bmp_sample* sample){
+        bmp280_compensate(&this->calib, raw, sample);
+    }
+
+    void settings(uint8_t, uint8_t, uint8_t){}
+
+    int getStatus(){
+        return 0;
+    }
+};
+
+static uint64_t published;
+
+struct sum_sink{
+    void operator()(const bmp_sample& sample){
+        published += sample.pressure;
+    }
+};
+
+typedef bmp_butterworth4<1000, 25000> lowpass;
+
+
+int main(){
+    const uint64_t samples = 20000000;
+    host_sensor sensor;
+    bmp280_parseCalibration(calibration, 0, &sensor.calib);
+
+    bmp_pipeline<bmp_compensate_stage<host_sensor>, bmp_filter_stage<lowpass>, bmp_decimate_stage<4>, bmp_publish_stage<sum_sink> > pipeline;
+    pipeline.stage<0>().bind(&sensor);
+    uint64_t pipeline_sum = 0;
+    double pipeline_ns = benchBest(samples, [&](uint64_t n){
+        pipeline.reset();
+        sensor.n = 0;
+        published = 0;
+        for(uint64_t i = 0; i < n; i++) pipeline.acquire(sensor);
+        pipeline_sum = published;
+    });
+
+    uint64_t hand_sum = 0;
+    double hand_ns = benchBest(samples, [&](uint64_t n){
+        lowpass filter;
+        sum_sink sink;
+        int decimate = 0;
+        sensor.n = 0;
+        published = 0;
+        for(uint64_t i = 0; i < n; i++){
+            bmp_raw raw;
+            if(sensor.readRaw(&raw)) continue;
+            bmp_sample sample;
+            sensor.compensate(&raw, &sample);
+            sample.pressure = (uint32_t)filter.process((int32_t)sample.pressure);
+            if(++decimate < 4) continue;
+            decimate = 0;
+            sink(sample);
+        }
+        hand_sum = published;
+    });
+
+    printf("bench_pipeline: pipeline %.2f ns/sample, hand-written %.2f ns/sample (%s)\n",
+           pipeline_ns, hand_ns, (pipeline_sum == hand_sum) ? "same output" : "OUTPUT DIFFERS");
+    return (pipeline_sum == hand_sum) ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file bench_reprocess.cpp
+ * @author Denys Khmil
+ * @brief Host benchmark: per-core scaling of tools/bmp280_reprocess on a generated week of frames
+ * @note Writes a calibration and a 1 Hz raw log to the build directory, archives it with
+ *       bmp280_archive and runs bmp280_reprocess --scaling --verify over eight copies of it
+ *       (4.8M samples). Thread counts go past the core count, those rows show the cost of
+ *       oversubscription. Fails when --verify finds a difference above the tool's tolerance
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#define BENCH_DIR           "build/"
+#define BENCH_CALIB         BENCH_DIR "reprocess_calib.txt"
+#define BENCH_LOG           BENCH_DIR "reprocess_week.log"
+#define BENCH_ARCHIVE       BENCH_DIR "reprocess_week.bmpa"
+#define BENCH_FRAMES        604800
+#define BENCH_COPIES        8
+
+static const char calibration[] = "70 6b 43 67 18 fc 7d 8e 43 d6 d0 0b 27 0b 8c 00 f9 ff 8c 3c f8 c6 70 17\n";
+
+/**
+ * @brief 1 Hz raw frames: daily temperature swing, weather fronts, noise and rare spikes
+ */
+static int writeLog(){
+    FILE* file = fopen(BENCH_LOG, "w");
+    if(!file) return 0;
+    uint32_t seed = 1;
+    for(uint32_t i = 0; i < BENCH_FRAMES; i++){
+        seed = seed * 1103515245 + 12345;
+        int32_t noise = (int32_t)((seed >> 16) % 9) - 4;
+        double day = sin(2.0 * M_PI * i / 86400.0);
+        double weather = sin(2.0 * M_PI * i / 259200.0) + 0.5 * sin(2.0 * M_PI * i / 97000.0);
+        int32_t temperature = (int32_t)(519888 + 4000 * day) + noise;
+        int32_t pressure = (int32_t)(415148 + 3000 * weather - 200 * day) + noise;
+        if((seed >> 8) % 5000 == 0) pressure += 2000;
+        fprintf(file, "%llu %d %d\n", 1700000000000ULL + 1000ULL * i, temperature, pressure);
+    }
+    fclose(file);
+    return 1;
+}
+
+
+int main(){
+    FILE* file = fopen(BENCH_CALIB, "w");
+    if(!file || fputs(calibration, file) < 0) return 1;
+    fclose(file);
+    if(!writeLog()) return 1;
+    if(system(BENCH_DIR "bmp280_archive build --calib " BENCH_CALIB " " BENCH_LOG " " BENCH_ARCHIVE " > /dev/null")) return 1;
+
+    unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+    std::string command = BENCH_DIR "bmp280_reprocess --scaling --verify --threads " + std::to_string(threads);
+    for(int i = 0; i < BENCH_COPIES; i++) command += " " BENCH_ARCHIVE;
+    printf("bench_reprocess: %u hardware threads\n", std::thread::hardware_concurrency());
+    fflush(stdout);
+    return system(command.c_str()) ? 1 : 0;
+}
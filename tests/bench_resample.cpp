@@ -0,0 +1,104 @@
+/**
+ * @file bench_resample.cpp
+ * @author Denys Khmil
+ * @brief Host benchmark: 16 streams at 100 Hz with drifting clocks resampled onto one 100 Hz clock
+ */
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "bmp_resample.h"
+#include "bench.h"
+
+#define BENCH_STREAMS       16
+#define BENCH_PERIOD_US     10000
+#define BENCH_DURATION_US   600000000.0     /*10 minutes of data*/
+#define BENCH_START_US      0xEE6B2800UL    /*timestamps wrap 5 minutes in*/
+
+/**
+ * @brief One input sample as it arrives
+ */
+struct arrival{
+    uint32_t time;
+    uint32_t pressure;
+    uint8_t stream;
+};
+
+/**
+ * @brief Pressure in Pa at t seconds after the start
+ */
+static double signal(double t){
+    return 100000.0 + 50.0 * sin(2.0 * M_PI * 0.7 * t) + 20.0 * sin(2.0 * M_PI * 3.1 * t);
+}
+
+
+/**
+ * @brief Inputs of all streams in arrival order, stream clocks off by up to +-2 %
+ */
+static std::vector<arrival> arrivals(){
+    std::vector<arrival> input;
+    double period[BENCH_STREAMS];
+    double next[BENCH_STREAMS];
+    for(int i = 0; i < BENCH_STREAMS; i++){
+        period[i] = BENCH_PERIOD_US * (1.0 + 0.02 * ((i * 7 % 9) - 4) / 4.0);
+        next[i] = i * 613.0;
+    }
+    for(double now = 0.0; now < BENCH_DURATION_US; now += 1000.0){
+        for(int i = 0; i < BENCH_STREAMS; i++){
+            for(; next[i] <= now; next[i] += period[i]){
+                arrival a = {(uint32_t)(BENCH_START_US + (uint64_t)next[i]), (uint32_t)llround(signal(next[i] * 1e-6) * 256.0), (uint8_t)i};
+                input.push_back(a);
+            }
+        }
+    }
+    return input;
+}
+
+
+/**
+ * @brief Feed the inputs and drain the output clock after each one
+ * @param squared: sum of squared errors in Pa^2 (0 to skip the check).
+ * @retval Output ticks
+ */
+static uint32_t run(const std::vector<arrival>& input, uint64_t n, uint8_t mode, double* squared, uint32_t* skipped){
+    bmp_resampler streams[BENCH_STREAMS];
+    for(bmp_resampler& stream : streams) stream.setMode(mode);
+    bmp_resample_bank bank(streams, BENCH_STREAMS, BENCH_PERIOD_US);
+    bmp_sample out[BENCH_STREAMS];
+    uint32_t time;
+    uint32_t ticks = 0;
+    for(uint64_t i = 0; i < n; i++){
+        bmp_sample sample = {2500, input[i].pressure, 0};
+        streams[input[i].stream].push(input[i].time, &sample);
+        while(bank.next(out, &time)){
+            ticks++;
+            if(!squared) continue;
+            double expected = signal((uint32_t)(time - BENCH_START_US) * 1e-6);
+            for(int s = 0; s < BENCH_STREAMS; s++){
+                double error = out[s].pressure / 256.0 - expected;
+                *squared += error * error;
+            }
+        }
+    }
+    benchKeep(out);
+    if(skipped) *skipped = bank.skipped();
+    return ticks;
+}
+
+
+int main(){
+    std::vector<arrival> input = arrivals();
+    const char* names[2] = {"linear", "cubic"};
+    for(uint8_t mode = BMP_RESAMPLE_LINEAR; mode <= BMP_RESAMPLE_CUBIC; mode++){
+        double squared = 0.0;
+        uint32_t skipped = 0;
+        uint32_t ticks = run(input, input.size(), mode, &squared, &skipped);
+        double ns = benchBest(input.size(), [&](uint64_t n){
+            run(input, n, mode, 0, 0);
+        });
+        /*16 streams at 100 Hz are 1600 inputs per second*/
+        printf("bench_resample: %s %.1f ns per input (%.1f M/s, %.4f %% of a core at 16x100 Hz), %u ticks, %u skipped, rms %.4f Pa\n",
+               names[mode], ns, 1e3 / ns, 1600.0 * ns * 1e-7, ticks, skipped, sqrt(squared / ticks / BENCH_STREAMS));
+    }
+    return 0;
+}
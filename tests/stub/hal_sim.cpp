@@ -0,0 +1,81 @@
+/**
+ * @file hal_sim.cpp
+ * @author Denys Khmil
+ * @brief This file contents the host HAL stub functions
+ */
+#include "hal_sim.h"
+
+static uint32_t simTick = 0;
+
+/**
+ * @brief Bind handle to simulated bus, the handle is copied by the drivers so the bus travels in Instance
+ */
+void hal_sim_attach(I2C_HandleTypeDef* hi2c, hal_sim_bus* bus){
+    for(uint8_t i = 0; i < 128; i++) bus->devices[i] = 0;
+    bus->transfers = 0;
+    hi2c->Instance = bus;
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->ErrorCode = 0;
+}
+
+
+/**
+ * @brief Place device at 7-bit address (0 removes it)
+ */
+void hal_sim_connect(hal_sim_bus* bus, uint8_t address, hal_sim_device* device){
+    bus->devices[address & 0x7F] = device;
+}
+
+
+void hal_sim_advance(uint32_t ms){
+    simTick += ms;
+}
+
+
+static hal_sim_device* target(I2C_HandleTypeDef* hi2c, uint16_t DevAddress){
+    hal_sim_bus* bus = (hal_sim_bus*)hi2c->Instance;
+    if(!bus) return 0;
+    bus->transfers++;
+    return bus->devices[(DevAddress >> 1) & 0x7F];
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t, uint8_t* pData, uint16_t Size, uint32_t){
+    hal_sim_device* device = target(hi2c, DevAddress);
+    return device ? device->read((uint8_t)MemAddress, pData, Size) : HAL_ERROR;
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t, uint8_t* pData, uint16_t Size, uint32_t){
+    hal_sim_device* device = target(hi2c, DevAddress);
+    return device ? device->write((uint8_t)MemAddress, pData, Size) : HAL_ERROR;
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t* pData, uint16_t Size){
+    if(hi2c->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    HAL_StatusTypeDef result = HAL_I2C_Mem_Read(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, 0);
+    hi2c->ErrorCode = (result == HAL_OK) ? 0 : 1;
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef* hi2c, uint16_t){
+    hi2c->State = HAL_I2C_STATE_READY;
+    return HAL_OK;
+}
+
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c){
+    return hi2c->State;
+}
+
+
+uint32_t HAL_GetTick(void){
+    return simTick;
+}
+
+
+void HAL_Delay(uint32_t Delay){
+    simTick += Delay;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file hal_sim.h
+ * @author Denys Khmil
+ * @brief Host simulation of i2c buses and register mapped devices behind the HAL stub
+ */
+#ifndef HAL_SIM
+#define HAL_SIM
+
+#include "main.h"
+
+/**
+ * @brief Register mapped i2c device
+ */
+class hal_sim_device{
+public:
+    virtual ~hal_sim_device(){}
+    virtual HAL_StatusTypeDef read(uint8_t reg, uint8_t* data, uint16_t length) = 0;
+    virtual HAL_StatusTypeDef write(uint8_t reg, const uint8_t* data, uint16_t length) = 0;
+};
+
+/**
+ * @brief Simulated bus with up to 128 7-bit addresses
+ * @note Interrupt transfers complete at once, the handle stays READY
+ */
+struct hal_sim_bus{
+    hal_sim_device* devices[128];
+    uint32_t transfers;
+};
+
+void hal_sim_attach(I2C_HandleTypeDef* hi2c, hal_sim_bus* bus);
+void hal_sim_connect(hal_sim_bus* bus, uint8_t address, hal_sim_device* device);
+
+/*TIME (ms, advanced by HAL_Delay() and hal_sim_advance())*/
+void hal_sim_advance(uint32_t ms);
+
+#endif
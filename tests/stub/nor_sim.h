@@ -0,0 +1,122 @@
+/**
+ * @file nor_sim.h
+ * @author Denys Khmil
+ * @brief Host simulation of a NOR flash with erase/program timing and power loss
+ */
+#ifndef NOR_SIM
+#define NOR_SIM
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+/**
+ * @brief NOR flash in the Flash interface of bmp_logger
+ * @note Erase sets a sector to 0xFF, program can only clear bits. Operations take erase_us or
+ *       program_us of simulated time (advance()); busy() completes them. powerLoss() stops the
+ *       running operation with only part of it applied, like a supply cut mid-operation.
+ *       Programs that would need to set a cleared bit are counted in overwrites()
+ */
+class nor_sim{
+public:
+    nor_sim(uint32_t _size, uint32_t _sector_size, uint32_t _erase_us, uint32_t _program_us)
+        : memory(_size, 0xFF), wear(_size / _sector_size, 0){
+        this->sector = _sector_size;
+        this->eraseTime = _erase_us;
+        this->programTime = _program_us;
+        this->now = 0;
+        this->doneAt = 0;
+        this->operation = none;
+        this->target = 0;
+        this->overwriteCount = 0;
+    }
+
+    /*FLASH INTERFACE*/
+    uint8_t busy(){
+        if(this->operation != none && this->now >= this->doneAt) this->apply(0, this->length());
+        return this->operation != none;
+    }
+
+    uint8_t erase(uint32_t address){
+        if(this->busy() || address % this->sector || address >= this->memory.size()) return 0;
+        this->start(erasing, address, this->eraseTime);
+        return 1;
+    }
+
+    uint8_t program(uint32_t address, const uint8_t* data, uint16_t length){
+        if(this->busy() || address + length > this->memory.size()) return 0;
+        this->data.assign(data, data + length);
+        this->start(programming, address, this->programTime);
+        return 1;
+    }
+
+    uint8_t read(uint32_t address, uint8_t* data, uint16_t length){
+        if(this->busy() || address + length > this->memory.size()) return 0;
+        memcpy(data, &this->memory[address], length);
+        return 1;
+    }
+
+    uint32_t sectorSize(){ return this->sector; }
+    uint32_t size(){ return (uint32_t)this->memory.size(); }
+
+    /*SIMULATION*/
+    void advance(uint32_t us){
+        this->now += us;
+    }
+
+    /**
+     * @brief Cut power: bytes [from, to) of the running operation are applied, the rest is not
+     */
+    void powerLoss(uint32_t from, uint32_t to){
+        if(this->operation == none) return;
+        if(to > this->length()) to = this->length();
+        this->apply(from, to);
+    }
+
+    uint8_t running() const{ return this->operation != none; }
+    uint32_t erases(uint32_t index) const{ return this->wear[index]; }
+    uint32_t overwrites() const{ return this->overwriteCount; }
+    uint8_t* raw(uint32_t address){ return &this->memory[address]; }
+
+private:
+    enum operation_t{ none, erasing, programming };
+
+    void start(operation_t _operation, uint32_t address, uint32_t duration){
+        this->operation = _operation;
+        this->target = address;
+        this->doneAt = this->now + duration;
+    }
+
+    uint32_t length() const{
+        return (this->operation == erasing) ? this->sector : (uint32_t)this->data.size();
+    }
+
+    void apply(uint32_t from, uint32_t to){
+        if(this->operation == erasing){
+            if(from < to) memset(&this->memory[this->target + from], 0xFF, to - from);
+            if(from == 0 && to == this->sector) this->wear[this->target / this->sector]++;
+        }
+        else{
+            for(uint32_t i = from; i < to; i++){
+                uint8_t& cell = this->memory[this->target + i];
+                if(this->data[i] & ~cell) this->overwriteCount++;
+                cell &= this->data[i];
+            }
+        }
+        this->operation = none;
+    }
+
+    std::vector<uint8_t> memory;
+    std::vector<uint32_t> wear;
+    std::vector<uint8_t> data;
+    uint32_t sector;
+    uint32_t eraseTime;
+    uint32_t programTime;
+    uint64_t now;
+    uint64_t doneAt;
+    operation_t operation;
+    uint32_t target;
+    uint32_t overwriteCount;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @file test.h
+ * @author Denys Khmil
+ * @brief Minimal check macros for the host tests
+ */
+#ifndef BMP_TEST
+#define BMP_TEST
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define CHECK(condition) do{ \
+        if(!(condition)){ \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    }while(0)
+
+#define CHECK_EQ(a, b) do{ \
+        long long _a = (long long)(a), _b = (long long)(b); \
+        if(_a != _b){ \
+            printf("%s:%d: %s == %s failed (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+            testFailures++; \
+        } \
+    }while(0)
+
+/**
+ * @brief Print result and return the exit code of the test
+ */
+static inline int testResult(const char* name){
+    printf("%s: %s\n", name, testFailures ? "FAILED" : "ok");
+    return testFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file test_bmp388_fifo.cpp
+ * @author Denys Khmil
+ * @brief Host test: bmp388::readFifo() against a simulated BMP388 with a 512 byte fifo
+ */
+#include <string.h>
+#include <deque>
+#include <vector>
+
+#include "bmp388_lib.h"
+#include "hal_sim.h"
+#include "test.h"
+
+static const uint8_t calibration[BMP388_CALIB_LENGTH] = {
+    0x6B, 0x6B, 0xD0, 0x48, 0xF6, 0x83, 0xFA, 0xD7, 0xFD, 0x2D, 0x0A,
+    0xF2, 0x01, 0x8E, 0x5C, 0x9E, 0x73, 0x03, 0xFA, 0x0E, 0xF1
+};
+
+/**
+ * @brief BMP388 register file with fifo, data read from FIFO_DATA leaves the fifo byte by byte
+ */
+class sim_bmp388 : public hal_sim_device{
+public:
+    sim_bmp388(){
+        memset(this->regs, 0, sizeof(this->regs));
+        this->regs[0x00] = BMP388_CHIP_ID;
+        memcpy(&this->regs[BMP388_CALIB_ADDR], calibration, BMP388_CALIB_LENGTH);
+        this->fifoReads = 0;
+    }
+
+    HAL_StatusTypeDef read(uint8_t reg, uint8_t* data, uint16_t length){
+        if(reg == 0x14){
+            this->fifoReads++;
+            for(uint16_t i = 0; i < length; i++){
+                if(this->fifo.empty()){
+                    data[i] = BMP388_FIFO_EMPTY;
+                    continue;
+                }
+                data[i] = this->fifo.front();
+                this->fifo.pop_front();
+            }
+            return HAL_OK;
+        }
+        this->regs[0x12] = (uint8_t)this->fifo.size();
+        this->regs[0x13] = (uint8_t)(this->fifo.size() >> 8);
+        for(uint16_t i = 0; i < length; i++) data[i] = this->regs[(reg + i) & 0x7F];
+        return HAL_OK;
+    }
+
+    HAL_StatusTypeDef write(uint8_t reg, const uint8_t* data, uint16_t length){
+        for(uint16_t i = 0; i < length; i++) this->regs[(reg + i) & 0x7F] = data[i];
+        if(reg == 0x7E && data[0] == 0xB0) this->fifo.clear();
+        return HAL_OK;
+    }
+
+    /**
+     * @brief Append frame if it fits, like the sensor does when the fifo is full in stop mode
+     */
+    uint8_t push(uint8_t header, uint32_t first, uint32_t second){
+        uint8_t size = (header == BMP388_FIFO_TEMP_PRESS) ? 6 : (header == BMP388_FIFO_CONFIG_CHG) ? 1 : 3;
+        if(this->fifo.size() + 1 + size > BMP388_FIFO_SIZE) return 0;
+        this->fifo.push_back(header);
+        if(header == BMP388_FIFO_CONFIG_CHG){
+            this->fifo.push_back(0);
+            return 1;
+        }
+        for(uint8_t i = 0; i < 3; i++) this->fifo.push_back((uint8_t)(first >> (8 * i)));
+        if(size == 6){
+            for(uint8_t i = 0; i < 3; i++) this->fifo.push_back((uint8_t)(second >> (8 * i)));
+        }
+        return 1;
+    }
+
+    std::deque<uint8_t> fifo;
+    uint32_t fifoReads;
+
+private:
+    uint8_t regs[128];
+};
+
+/**
+ * @brief Host side reference of the expected samples
+ */
+struct expectation{
+    expectation(){
+        bmp388_parseCalibration(calibration, &this->calib);
+        this->temperature = 0;
+    }
+
+    void frame(uint8_t header, uint32_t first, uint32_t second){
+        if(header == BMP388_FIFO_CONFIG_CHG) return;
+        if(header != BMP388_FIFO_PRESS) this->temperature = (int32_t)first;
+        if(header == BMP388_FIFO_TEMP) return;
+        bmp_raw raw = {this->temperature, (int32_t)((header == BMP388_FIFO_PRESS) ? first : second), 0};
+        bmp_sample sample;
+        bmp388_compensate(&this->calib, &raw, &sample);
+        this->samples.push_back(sample);
+    }
+
+    bmp388_calib calib;
+    int32_t temperature;
+    std::vector<bmp_sample> samples;
+};
+
+static uint8_t same(const bmp_sample& a, const bmp_sample& b){
+    return a.temperature == b.temperature && a.pressure == b.pressure && a.humidity == b.humidity;
+}
+
+
+static void add(sim_bmp388& device, expectation& expected, uint8_t header, uint32_t first, uint32_t second = 0){
+    if(device.push(header, first, second)) expected.frame(header, first, second);
+}
+
+
+int main(){
+    I2C_HandleTypeDef i2c;
+    hal_sim_bus bus;
+    sim_bmp388 device;
+    hal_sim_attach(&i2c, &bus);
+    hal_sim_connect(&bus, BMP388_ADDRESS_PRIMARY, &device);
+    bmp388 sensor(i2c);
+    sensor.setFifo(16, 0);
+    bmp_sample samples[BMP388_FIFO_MAX_FRAMES];
+
+    /*full fifo of temperature+pressure frames drains in one burst*/
+    {
+        expectation expected;
+        for(uint32_t i = 0; i < 100; i++) add(device, expected, BMP388_FIFO_TEMP_PRESS, 8400000 + 13 * i, 6500000 + 101 * i);
+        CHECK_EQ(expected.samples.size(), BMP388_FIFO_MAX_FRAMES);
+        uint32_t reads = device.fifoReads;
+        uint16_t count = sensor.readFifo(samples, BMP388_FIFO_MAX_FRAMES);
+        CHECK_EQ(count, expected.samples.size());
+        CHECK_EQ(device.fifoReads - reads, 1);
+        CHECK(device.fifo.empty());
+        for(uint16_t i = 0; i < count; i++) CHECK(same(samples[i], expected.samples[i]));
+    }
+
+    /*config change and pressure-only frames, storage smaller than the fifo content*/
+    {
+        expectation expected;
+        add(device, expected, BMP388_FIFO_TEMP_PRESS, 8410000, 6510000);
+        add(device, expected, BMP388_FIFO_CONFIG_CHG, 0);
+        for(uint32_t i = 0; i < 6; i++) add(device, expected, BMP388_FIFO_PRESS, 6510000 + 7 * i);
+        add(device, expected, BMP388_FIFO_TEMP, 8420000);
+        add(device, expected, BMP388_FIFO_CONFIG_CHG, 0);
+        add(device, expected, BMP388_FIFO_PRESS, 6520000);
+        add(device, expected, BMP388_FIFO_TEMP, 8430000);
+        CHECK_EQ(expected.samples.size(), 8);
+
+        uint16_t count = sensor.readFifo(samples, 3);
+        CHECK_EQ(count, 3);
+        CHECK(device.fifo.empty());
+        for(uint16_t i = 0; i < count; i++) CHECK(same(samples[i], expected.samples[i]));
+
+        /*the dropped frames still carried the newest temperature*/
+        add(device, expected, BMP388_FIFO_PRESS, 6530000);
+        count = sensor.readFifo(samples, BMP388_FIFO_MAX_FRAMES);
+        CHECK_EQ(count, 1);
+        CHECK(same(samples[0], expected.samples.back()));
+    }
+
+    /*odd frame sizes never split across reads*/
+    {
+        expectation expected;
+        uint32_t delivered = 0;
+        for(uint32_t round = 0; round < 50; round++){
+            for(uint32_t i = 0; i < 5 + round % 7; i++){
+                if(i % 3 == 0) add(device, expected, BMP388_FIFO_CONFIG_CHG, 0);
+                if(i % 2) add(device, expected, BMP388_FIFO_PRESS, 6500000 + round * 100 + i);
+                else add(device, expected, BMP388_FIFO_TEMP_PRESS, 8400000 + round, 6500000 + round * 100 + i);
+            }
+            uint16_t count = sensor.readFifo(samples, BMP388_FIFO_MAX_FRAMES);
+            CHECK(device.fifo.empty());
+            for(uint16_t i = 0; i < count; i++) CHECK(same(samples[i], expected.samples[delivered + i]));
+            delivered += count;
+        }
+        CHECK_EQ(delivered, expected.samples.size());
+    }
+
+    /*flush and empty fifo*/
+    device.push(BMP388_FIFO_TEMP_PRESS, 8400000, 6500000);
+    sensor.flushFifo();
+    CHECK_EQ(sensor.fifoLength(), 0);
+    CHECK_EQ(sensor.readFifo(samples, BMP388_FIFO_MAX_FRAMES), 0);
+
+    /*a zero bus clock keeps the previous one, timeouts stay defined*/
+    sensor.setBusClock(0);
+    device.push(BMP388_FIFO_TEMP_PRESS, 8400000, 6500000);
+    CHECK_EQ(sensor.fifoLength(), 7);
+    CHECK_EQ(sensor.readFifo(samples, BMP388_FIFO_MAX_FRAMES), 1);
+
+    return testResult("test_bmp388_fifo");
+}
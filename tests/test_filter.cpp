@@ -0,0 +1,87 @@
+/**
+ * @file test_filter.cpp
+ * @author Denys Khmil
+ * @brief Host test: frequency response and DC exactness of the fixed-point biquads
+ */
+#include <math.h>
+
+#include "bmp_filter.h"
+#include "test.h"
+
+#define TEST_DC     25600000
+#define TEST_SWING  100000.0
+
+/**
+ * @brief Measured gain of Filter for a sine of f_hz sampled at fs_hz
+ * @note Correlates the second half of the output with sine and cosine of the input frequency
+ */
+template<typename Filter>
+static double gain(double f_hz, double fs_hz){
+    Filter filter;
+    const int samples = 200000;
+    double in_phase = 0.0;
+    double quadrature = 0.0;
+    double power = 0.0;
+    for(int i = 0; i < samples; i++){
+        double phase = 2.0 * M_PI * f_hz / fs_hz * i;
+        int32_t y = filter.process((int32_t)(TEST_DC + TEST_SWING * sin(phase)));
+        if(i < samples / 2) continue;
+        in_phase += (y - (double)TEST_DC) * sin(phase);
+        quadrature += (y - (double)TEST_DC) * cos(phase);
+        power += TEST_SWING * sin(phase) * sin(phase);
+    }
+    return sqrt(in_phase * in_phase + quadrature * quadrature) / power;
+}
+
+
+/**
+ * @brief Output after a long constant input
+ */
+template<typename Filter>
+static int32_t settle(int32_t value, int samples){
+    Filter filter;
+    int32_t y = 0;
+    filter.process(0);
+    for(int i = 0; i < samples; i++) y = filter.process(value);
+    return y;
+}
+
+
+/**
+ * @brief Analog Butterworth magnitude of order n
+ */
+static double butterworth(double f, double fc, int n){
+    return 1.0 / sqrt(1.0 + pow(f / fc, 2 * n));
+}
+
+
+int main(){
+    /*2 Hz at 100 Hz, second order*/
+    typedef bmp_biquad<bmp_lowpass<2000, 100000> > lowpass2;
+    const double frequencies[5] = {0.5, 1.0, 2.0, 4.0, 10.0};
+    for(double f : frequencies){
+        double measured = gain<lowpass2>(f, 100.0);
+        CHECK(fabs(measured - butterworth(f, 2.0, 2)) < 0.02);
+    }
+    CHECK(fabs(gain<lowpass2>(2.0, 100.0) - M_SQRT1_2) < 0.002);
+
+    /*4th order cascade*/
+    typedef bmp_butterworth4<2000, 100000> lowpass4;
+    CHECK(fabs(gain<lowpass4>(2.0, 100.0) - M_SQRT1_2) < 0.005);
+    CHECK(fabs(gain<lowpass4>(4.0, 100.0) - butterworth(4.0, 2.0, 4)) < 0.005);
+    CHECK(gain<lowpass4>(20.0, 100.0) < 1e-3);
+
+    /*DC comes back exact, also for cutoffs far below the sample rate*/
+    CHECK_EQ(settle<lowpass2>(25600123, 100000), 25600123);
+    CHECK_EQ(settle<lowpass4>(25600123, 100000), 25600123);
+    typedef bmp_biquad<bmp_lowpass<100, 100000> > lowpass_slow;
+    CHECK_EQ(settle<lowpass_slow>(25600123, 3000000), 25600123);
+    CHECK_EQ(settle<lowpass2>(-1234567, 100000), -1234567);
+
+    /*first sample primes the state, no transient*/
+    lowpass4 primed;
+    CHECK_EQ(primed.process(25600000), 25600000);
+    CHECK_EQ(primed.process(25600000), 25600000);
+
+    return testResult("test_filter");
+}
@@ -0,0 +1,212 @@
+/**
+ * @file test_history.cpp
+ * @author Denys Khmil
+ * @brief Host test: bmp_history cascade, gaps, clamping and tendency against a brute force reference
+ */
+#include <math.h>
+#include <map>
+
+#include "bmp_history.h"
+#include "test.h"
+
+#define TEST_BASE_PA    95000
+#define Q8(pa)          ((uint32_t)(pa) * 256)
+
+/**
+ * @brief Every sample summed straight into the buckets of every level
+ */
+struct reference{
+    struct aggregate{
+        int64_t sum;
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+    };
+
+    void add(uint32_t time_s, uint32_t pressure){
+        if(!this->samples) this->first = time_s;
+        this->last = time_s;
+        this->samples++;
+        for(uint8_t level = 0; level < BMP_HISTORY_LEVELS; level++){
+            uint32_t id = time_s / this->history.duration(level);
+            auto found = this->buckets[level].find(id);
+            if(found == this->buckets[level].end()){
+                this->buckets[level][id] = {pressure, 1, pressure, pressure};
+                continue;
+            }
+            aggregate& a = found->second;
+            a.sum += pressure;
+            a.count++;
+            if(pressure < a.min) a.min = pressure;
+            if(pressure > a.max) a.max = pressure;
+        }
+    }
+
+    static uint32_t quantize(int64_t pressure){
+        int64_t pascal = (pressure + 128) / 256;
+        if(pascal < BMP_HISTORY_BASE_PA) pascal = BMP_HISTORY_BASE_PA;
+        if(pascal > BMP_HISTORY_BASE_PA + BMP_HISTORY_MISSING - 1) pascal = BMP_HISTORY_BASE_PA + BMP_HISTORY_MISSING - 1;
+        return (uint32_t)pascal * 256;
+    }
+
+    /**
+     * @brief Every stored bucket of every level matches, missing ones read as missing
+     * @note The open bucket of a level holds the last sample folded into it: the newest
+     *       sample at level 0, the start of the newest closed bucket below it higher up
+     */
+    void check(const bmp_history& h) const{
+        uint32_t folded = this->last;
+        uint8_t open = 1;
+        for(uint8_t level = 0; level < BMP_HISTORY_LEVELS; level++){
+            uint32_t duration = this->history.duration(level);
+            uint32_t openId = folded / duration;
+            uint32_t firstId = this->first / duration;
+            for(uint16_t age = 0; age < h.length(level); age++){
+                bmp_history_bucket bucket;
+                uint8_t stored = h.bucket(level, age, &bucket);
+                if(!open || openId < firstId + 1 + age){
+                    CHECK_EQ(stored, 0);
+                    continue;
+                }
+                auto found = this->buckets[level].find(openId - 1 - age);
+                CHECK_EQ(stored, found != this->buckets[level].end());
+                if(!stored || found == this->buckets[level].end()) continue;
+                const aggregate& a = found->second;
+                CHECK_EQ(bucket.min, quantize(a.min));
+                CHECK_EQ(bucket.max, quantize(a.max));
+                CHECK_EQ(bucket.mean, quantize((a.sum + a.count / 2) / a.count));
+            }
+            /*newest closed bucket of this level*/
+            auto newest = this->buckets[level].lower_bound(openId);
+            open = open && newest != this->buckets[level].begin();
+            if(open) folded = (--newest)->first * duration;
+        }
+    }
+
+    bmp_history history;
+    std::map<uint32_t, aggregate> buckets[BMP_HISTORY_LEVELS];
+    uint32_t samples = 0;
+    uint32_t first = 0;
+    uint32_t last = 0;
+};
+
+/**
+ * @brief Weather-like Q24.8 pressure: slow fall, a 5 h wave, noise
+ */
+static uint32_t pressureAt(uint32_t time_s, uint32_t* seed){
+    *seed = *seed * 1103515245 + 12345;
+    double pa = TEST_BASE_PA - 36.0 * time_s / 3600.0 + 80.0 * sin(2 * M_PI * time_s / 18000.0);
+    return (uint32_t)(pa * 256) + (*seed >> 16) % 1024;
+}
+
+
+static void add(bmp_history& h, uint32_t time_s, uint32_t pressure){
+    bmp_sample sample = {2000, pressure, 0};
+    h.add(time_s, &sample);
+}
+
+
+/**
+ * @brief Tendency over span matches the two means of level, age span / duration
+ */
+static void checkTendency(const bmp_history& h, uint32_t span_s, uint8_t level){
+    int32_t delta;
+    bmp_history_bucket now, then;
+    uint16_t age = (uint16_t)(span_s / h.duration(level));
+    CHECK(h.tendency(span_s, &delta));
+    CHECK(h.bucket(level, 0, &now));
+    CHECK(h.bucket(level, age, &then));
+    CHECK_EQ(delta, (int32_t)(now.mean - then.mean));
+}
+
+
+int main(){
+    /*52 h at 1 Hz with gaps of 7 s, 25 min and 3 h: cascade into every level*/
+    {
+        bmp_history h;
+        reference r;
+        uint32_t seed = 1;
+        for(uint32_t t = 1000; t < 1000 + 52 * 3600; t++){
+            if((t >= 5000 && t < 5007) || (t >= 20000 && t < 21500) || (t >= 100000 && t < 110800)) continue;
+            uint32_t pressure = pressureAt(t, &seed);
+            add(h, t, pressure);
+            r.add(t, pressure);
+            if(t % 997 == 0 || t == 5007 + 5 || t == 21500 + 60 || t == 110800 + 3600) r.check(h);
+        }
+        r.check(h);
+        for(uint8_t level = 0; level < BMP_HISTORY_LEVELS; level++){
+            bmp_history_bucket bucket;
+            CHECK(h.bucket(level, 0, &bucket));
+            CHECK(!h.bucket(level, h.length(level), &bucket));
+        }
+        CHECK(!h.bucket(BMP_HISTORY_LEVELS, 0, 0));
+
+        /*finest level that holds the span*/
+        checkTendency(h, 60, 0);
+        checkTendency(h, 1800, 1);
+        checkTendency(h, 3600, 2);
+        checkTendency(h, 3 * 3600, 2);
+        checkTendency(h, 24 * 3600, 3);
+        checkTendency(h, 47 * 3600, 3);
+        int32_t delta;
+        CHECK(!h.tendency(48 * 3600, &delta));
+        CHECK(!h.tendency(0, &delta));
+
+        /*3 h from hourly means differs here: the wave does not average out over 10 min buckets*/
+        bmp_history_bucket now, then;
+        h.tendency(3 * 3600, &delta);
+        h.bucket(3, 0, &now);
+        h.bucket(3, 3, &then);
+        CHECK(delta != (int32_t)(now.mean - then.mean));
+    }
+
+    /*a gap longer than every ring: all missing but the newest buckets, tendency needs both ends*/
+    {
+        bmp_history h;
+        reference r;
+        uint32_t seed = 2;
+        for(uint32_t t = 0; t < 4 * 3600; t++){
+            uint32_t pressure = pressureAt(t, &seed);
+            add(h, t, pressure);
+            r.add(t, pressure);
+        }
+        uint32_t resume = 4 * 3600 + 72 * 3600;
+        for(uint32_t t = resume; t < resume + 2 * 3600 + 1; t++){
+            uint32_t pressure = pressureAt(t, &seed);
+            add(h, t, pressure);
+            r.add(t, pressure);
+        }
+        r.check(h);
+        bmp_history_bucket bucket;
+        CHECK(h.bucket(3, 0, &bucket));
+        CHECK(!h.bucket(3, 1, &bucket));
+        CHECK(!h.bucket(3, 2, &bucket));
+        int32_t delta;
+        CHECK(h.tendency(3600, &delta));
+        CHECK(!h.tendency(3 * 3600, &delta));
+        CHECK(!h.tendency(24 * 3600, &delta));
+    }
+
+    /*clamping to 40000..105534 Pa, the mean of a higher level from the exact sum*/
+    {
+        bmp_history h;
+        const uint32_t values[6] = {Q8(30000), Q8(120000), Q8(40000), Q8(105534), Q8(70000), Q8(70000)};
+        const uint32_t clamped[5] = {Q8(40000), Q8(105534), Q8(40000), Q8(105534), Q8(70000)};
+        for(uint32_t t = 0; t < 6; t++) add(h, t, values[t]);
+        bmp_history_bucket bucket;
+        for(uint16_t age = 0; age < 5; age++){
+            CHECK(h.bucket(0, age, &bucket));
+            CHECK_EQ(bucket.min, clamped[4 - age]);
+            CHECK_EQ(bucket.max, clamped[4 - age]);
+            CHECK_EQ(bucket.mean, clamped[4 - age]);
+        }
+        add(h, 60, Q8(70000));
+        add(h, 61, Q8(70000));
+        CHECK(h.bucket(1, 0, &bucket));
+        CHECK_EQ(bucket.min, Q8(40000));
+        CHECK_EQ(bucket.max, Q8(105534));
+        CHECK_EQ(bucket.mean, Q8(72589));
+    }
+
+    return testResult("test_history");
+}
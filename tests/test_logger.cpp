@@ -0,0 +1,170 @@
+/**
+ * @file test_logger.cpp
+ * @author Denys Khmil
+ * @brief Host test: bmp_logger on a simulated NOR flash with power loss during erase and program
+ */
+#include <algorithm>
+#include <vector>
+
+#include "bmp_logger.h"
+#include "nor_sim.h"
+#include "test.h"
+
+#define TEST_FLASH_SIZE     65536
+#define TEST_SECTOR_SIZE    4096
+#define TEST_PAGE_SIZE      256
+#define TEST_ERASE_US       45000
+#define TEST_PROGRAM_US     700
+#define TEST_BOOTS          40
+
+typedef bmp_logger<nor_sim, TEST_PAGE_SIZE> test_logger;
+
+/**
+ * @brief Logging at 100 Hz, poll() every ms, record times count up by one
+ */
+struct session{
+    session() : flash(TEST_FLASH_SIZE, TEST_SECTOR_SIZE, TEST_ERASE_US, TEST_PROGRAM_US){
+        this->time = 0;
+        this->elapsed = 0;
+    }
+
+    void step(test_logger& logger, uint32_t ms){
+        for(uint32_t k = 0; k < ms; k++){
+            this->flash.advance(1000);
+            if(this->elapsed++ % 10 == 0){
+                bmp_sample sample = {(int32_t)(2000 + this->time % 100), 25600000 + this->time, 50 * 1024 + this->time % 1024};
+                logger.add(this->time++, &sample);
+            }
+            logger.poll();
+        }
+    }
+
+    /**
+     * @brief Run until a program of the page after pages already written is under way
+     */
+    void stepToProgram(test_logger& logger, uint32_t pages){
+        while(logger.written() < pages || !this->flash.running() || logger.writePosition() % (TEST_SECTOR_SIZE / TEST_PAGE_SIZE) == 0) this->step(logger, 1);
+    }
+
+    nor_sim flash;
+    uint32_t time;
+    uint32_t elapsed;
+};
+
+/**
+ * @brief Records of all valid pages in sequence order
+ */
+static std::vector<bmp_log_record> records(test_logger& logger){
+    std::vector<std::pair<uint32_t, uint32_t>> pages;
+    for(uint32_t page = 0; page < logger.pages(); page++){
+        uint32_t sequence;
+        if(logger.readPage(page, 0, 0, &sequence)) pages.push_back(std::make_pair(sequence, page));
+    }
+    std::sort(pages.begin(), pages.end());
+    std::vector<bmp_log_record> out;
+    for(auto& page : pages){
+        bmp_log_record buffer[test_logger::RecordsPerPage];
+        uint16_t count = 0;
+        logger.readPage(page.second, buffer, &count, 0);
+        out.insert(out.end(), buffer, buffer + count);
+    }
+    return out;
+}
+
+
+/**
+ * @brief Times increase, gaps come only from pages lost at a power cut, values as logged
+ * @retval Newest record time
+ */
+static uint32_t checkOrder(const std::vector<bmp_log_record>& log){
+    for(size_t i = 1; i < log.size(); i++){
+        CHECK(log[i].time > log[i - 1].time);
+        CHECK(log[i].time - log[i - 1].time <= 2 * test_logger::RecordsPerPage + 1);
+        CHECK_EQ(log[i].pressure, 25600000 + log[i].time);
+        CHECK_EQ(log[i].humidity, 5000 + (log[i].time % 1024 * 100 + 512) / 1024);
+    }
+    return log.empty() ? 0 : log.back().time;
+}
+
+
+int main(){
+    /*humidity from Q22.10 to 0.01 %RH, rounded*/
+    {
+        session s;
+        test_logger logger(&s.flash);
+        CHECK_EQ(logger.mount(), 0);
+        const uint32_t humidity[5] = {0, 50 * 1024 + 512, 52223, 100 * 1024, 1000 * 1024};
+        const uint16_t stored[5] = {0, 5050, 5100, 10000, UINT16_MAX};
+        for(uint32_t i = 0; i < 5; i++){
+            bmp_sample sample = {2000, 25600000, humidity[i]};
+            CHECK(logger.add(i, &sample));
+        }
+        logger.flush();
+        while(logger.poll()) s.flash.advance(1000);
+        std::vector<bmp_log_record> log = records(logger);
+        CHECK_EQ(log.size(), 5);
+        for(uint32_t i = 0; i < log.size() && i < 5; i++) CHECK_EQ(log[i].humidity, stored[i]);
+    }
+
+    /*torn program with the header still erased: the page must not be programmed again*/
+    {
+        session s;
+        test_logger logger(&s.flash);
+        CHECK_EQ(logger.mount(), 0);
+        s.stepToProgram(logger, 5);
+        uint32_t torn = logger.writePosition();
+        s.flash.powerLoss(BMP_LOG_HEADER_SIZE, TEST_PAGE_SIZE);
+
+        test_logger after(&s.flash);
+        CHECK_EQ(after.mount(), 5);
+        CHECK(after.writePosition() != torn);
+        uint32_t resumed = s.time;
+        s.step(after, 10000);
+        after.flush();
+        while(after.poll()) s.flash.advance(1000);
+        CHECK_EQ(s.flash.overwrites(), 0);
+        std::vector<bmp_log_record> log = records(after);
+        CHECK_EQ(log.size(), 5 * test_logger::RecordsPerPage + s.time - resumed);
+        checkOrder(log);
+    }
+
+    /*power cuts at random points of erase and program over many boots*/
+    {
+        session s;
+        uint32_t newest = 0;
+        uint32_t dropped = 0;
+        uint32_t seed = 12345;
+        for(uint32_t boot = 0; boot < TEST_BOOTS; boot++){
+            test_logger logger(&s.flash);
+            logger.mount();
+            std::vector<bmp_log_record> log = records(logger);
+            uint32_t last = checkOrder(log);
+            CHECK(last >= newest);
+            newest = last;
+
+            seed = seed * 1103515245 + 12345;
+            s.step(logger, 20000 + (seed >> 8) % 60000);
+            while(!s.flash.running()) s.step(logger, 1);
+            dropped += logger.dropped();
+
+            seed = seed * 1103515245 + 12345;
+            uint32_t cut = (seed >> 8) % TEST_PAGE_SIZE;
+            if(boot % 3 == 0) s.flash.powerLoss(0, cut);
+            else if(boot % 3 == 1) s.flash.powerLoss(cut, TEST_SECTOR_SIZE);
+            else s.flash.powerLoss(0, 0);
+        }
+        CHECK_EQ(dropped, 0);
+        CHECK_EQ(s.flash.overwrites(), 0);
+
+        uint32_t least = s.flash.erases(0);
+        uint32_t most = least;
+        for(uint32_t i = 1; i < TEST_FLASH_SIZE / TEST_SECTOR_SIZE; i++){
+            least = std::min(least, s.flash.erases(i));
+            most = std::max(most, s.flash.erases(i));
+        }
+        CHECK(least > 0);
+        CHECK(most - least <= 2);
+    }
+
+    return testResult("test_logger");
+}
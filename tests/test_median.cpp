@@ -0,0 +1,84 @@
+/**
+ * @file test_median.cpp
+ * @author Denys Khmil
+ * @brief Host test: streaming median and Hampel filter against a sorted window
+ */
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "bmp_median.h"
+#include "test.h"
+
+/**
+ * @brief Median of the last N values by sorting a copy of the window
+ */
+template<int N>
+struct sorted_median{
+    sorted_median() : window(N){
+        this->index = 0;
+        this->count = 0;
+    }
+
+    int32_t process(int32_t value){
+        this->ring[this->index] = value;
+        this->index = (this->index + 1) % N;
+        if(this->count < N) this->count++;
+        std::copy(this->ring, this->ring + this->count, this->window.begin());
+        std::sort(this->window.begin(), this->window.begin() + this->count);
+        if(this->count & 1) return this->window[this->count / 2];
+        return (int32_t)(((int64_t)this->window[this->count / 2] + this->window[this->count / 2 - 1]) / 2);
+    }
+
+    int32_t ring[N];
+    std::vector<int32_t> window;
+    int index;
+    int count;
+};
+
+/**
+ * @brief Compare against the sorted window on random input with many duplicates
+ */
+template<int N>
+static void check(){
+    bmp_median<N> median;
+    sorted_median<N> reference;
+    srand(N);
+    int mismatches = 0;
+    for(int i = 0; i < 200000; i++){
+        int32_t value = rand() % 1000 - 500;
+        if(median.process(value) != reference.process(value)) mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+
+int main(){
+    check<1>();
+    check<2>();
+    check<5>();
+    check<8>();
+    check<31>();
+    check<64>();
+
+    /*Hampel replaces isolated spikes and passes nearly all of the noise*/
+    bmp_hampel<15> hampel;
+    srand(1);
+    int replaced = 0;
+    int spikes = 0;
+    for(int i = 0; i < 10000; i++){
+        int32_t value = 25600000 + rand() % 200;
+        if(i % 500 == 499){
+            value += 100000;
+            spikes++;
+        }
+        int32_t output = hampel.process(value);
+        if(output != value) replaced++;
+        CHECK(output < 25600000 + 100000);
+    }
+    /*every spike, plus under 1% of the noise samples*/
+    CHECK(replaced >= spikes);
+    CHECK(replaced - spikes < 100);
+
+    return testResult("test_median");
+}
@@ -0,0 +1,92 @@
+/**
+ * @file test_model.cpp
+ * @author Denys Khmil
+ * @brief Host test: bmp280_model timing, current and energy figures pinned for reference configurations
+ * @note Expected values are worked out by hand from the model, with the datasheet typical
+ *       figure of the same mode in the comments. A change of any model constant shows up here
+ */
+#include "bmp280_model.h"
+#include "test.h"
+
+static const bmp280_bus_model bus = {400000, BMP280_BUS_VDD_MV, BMP280_BUS_CURRENT_UA};
+
+
+/**
+ * @brief ctrl_meas register value
+ */
+static uint8_t ctrlMeas(uint8_t osrs_t, uint8_t osrs_p, uint8_t mode){
+    return (uint8_t)((osrs_t << 5) | (osrs_p << 2) | mode);
+}
+
+
+int main(){
+    /*transfers at 400 kHz: (bytes + 3) * 9 + 3 bits at 3.3 V and 700 uA*/
+    CHECK_EQ(bmp280_transferEnergy(&bus, 1), 225);
+    CHECK_EQ(bmp280_transferEnergy(&bus, 6), 485);
+    CHECK_EQ(bmp280_transferEnergy(&bus, 8), 589);
+
+    /*forced x1/x1 at 1 Hz: 5.5 ms measurement, 2775 nC (datasheet ultra low power 2.74 uA)*/
+    {
+        bmp280_energy energy;
+        bmp280_estimateEnergy(ctrlMeas(0b001, 0b001, BMP280_MODE_FORCED), 0, 0, &bus, 1, 1000000, &energy);
+        CHECK_EQ(bmp280_measurementTime(0b001, 0b001), 5500);
+        CHECK_EQ(bmp280_measurementCharge(0b001, 0b001, 0), 2775);
+        CHECK_EQ(energy.period_us, 1000000);
+        CHECK_EQ(energy.sensor_na, 2875);
+        CHECK_EQ(energy.sensor_nj, 9487);
+        CHECK_EQ(energy.bus_nj, 485 + 225 + 225);
+
+        /*faster than the measurement: limited to back to back measurements*/
+        bmp280_estimateEnergy(ctrlMeas(0b001, 0b001, BMP280_MODE_FORCED), 0, 0, &bus, 0, 1000, &energy);
+        CHECK_EQ(energy.period_us, 5500);
+        CHECK_EQ(energy.sensor_na, 504645);
+    }
+
+    /*normal x16/x2, IIR 16, 0.5 ms standby: 37.5 ms measurement, 26.3 Hz (datasheet indoor navigation 650 uA)*/
+    {
+        bmp280_energy energy;
+        uint8_t config = (0b000 << 5) | (0b100 << 2);
+        bmp280_estimateEnergy(ctrlMeas(0b010, 0b101, BMP280_MODE_NORMAL), config, 0, &bus, 0, 0, &energy);
+        CHECK_EQ(bmp280_measurementTime(0b101, 0b010), 37500);
+        CHECK_EQ(bmp280_samplePeriod(0b101, 0b010, 0b000), 38000);
+        CHECK_EQ(bmp280_measurementCharge(0b101, 0b010, 0), 25025);
+        CHECK_EQ(energy.period_us, 38000);
+        CHECK_EQ(energy.sensor_na, 658752);
+        CHECK_EQ(energy.sensor_nj, 82607);
+        CHECK_EQ(energy.bus_nj, 485);
+        CHECK_EQ(bmp280_averageCurrent(0b101, 0b010, 0b000), energy.sensor_na);
+        CHECK_EQ(bmp280_filterSettleSamples(0b100), 22);
+    }
+
+    /*BME280 forced x1/x1/x1 with humidity at 1 Hz: 8 ms measurement, 3625 nC (datasheet 3.6 uA)*/
+    {
+        bmp280_energy energy;
+        bmp280_estimateEnergy(ctrlMeas(0b001, 0b001, BMP280_MODE_FORCED), 0, 0b001, &bus, 1, 1000000, &energy, 1);
+        CHECK_EQ(bmp280_measurementCharge(0b001, 0b001, 0b001), 3625);
+        CHECK_EQ(energy.period_us, 1000000);
+        CHECK_EQ(energy.sensor_na, 3725);
+        CHECK_EQ(energy.sensor_nj, 12292);
+        CHECK_EQ(energy.bus_nj, 589 + 225 + 225);
+
+        /*normal with t_sb 0b110: 10 ms standby on the BME280, 2 s on the bmp280*/
+        uint8_t config = 0b110 << 5;
+        bmp280_estimateEnergy(ctrlMeas(0b001, 0b001, BMP280_MODE_NORMAL), config, 0b001, &bus, 0, 0, &energy, 1);
+        CHECK_EQ(energy.period_us, 18000);
+        CHECK_EQ(energy.sensor_na, 201588);
+        CHECK_EQ(energy.bus_nj, 589);
+        CHECK_EQ(bmp280_standbyTime(0b110), 2000000);
+        CHECK_EQ(bmp280_standbyTime(0b110, 1), 10000);
+    }
+
+    /*sleep: only the sleep current*/
+    {
+        bmp280_energy energy;
+        bmp280_estimateEnergy(ctrlMeas(0b001, 0b001, BMP280_MODE_SLEEP), 0, 0, &bus, 1, 1000000, &energy);
+        CHECK_EQ(energy.period_us, 0);
+        CHECK_EQ(energy.sensor_na, BMP280_IDD_SLEEP_NA);
+        CHECK_EQ(energy.sensor_nj, 0);
+        CHECK_EQ(energy.bus_nj, 0);
+    }
+
+    return testResult("test_model");
+}
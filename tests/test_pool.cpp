@@ -0,0 +1,133 @@
+/**
+ * @file test_pool.cpp
+ * @author Denys Khmil
+ * @brief Host stress test: bmp_pool handoff between threads (run under -fsanitize=thread as well)
+ */
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bmp_pool.h"
+#include "bmp_sample.h"
+#include "test.h"
+
+#define TEST_POOL_BLOCKS    64
+#define TEST_RING_SIZE      128
+#define TEST_PAIRS          4
+#define TEST_ITERATIONS     500000
+
+static bmp_pool<bmp_sample, TEST_POOL_BLOCKS> pool;
+
+/**
+ * @brief Single producer single consumer ring of block pointers
+ */
+struct ring{
+    std::atomic<uint32_t> write;
+    std::atomic<uint32_t> read;
+    bmp_sample* blocks[TEST_RING_SIZE];
+};
+
+static ring rings[TEST_PAIRS];
+static std::atomic<uint32_t> corrupted(0);
+static std::atomic<uint32_t> moved(0);
+static std::atomic<uint32_t> badCount(0);
+static std::atomic<uint32_t> producersDone(0);
+
+
+/**
+ * @brief Fill blocks with a pattern owned by this producer and hand them over
+ */
+static void producer(int id){
+    ring& r = rings[id];
+    for(int i = 0; i < TEST_ITERATIONS; i++){
+        bmp_sample* sample = pool.acquire();
+        if(!sample){
+            std::this_thread::yield();
+            continue;
+        }
+        sample->temperature = id;
+        sample->pressure = (uint32_t)i;
+        sample->humidity = ~(uint32_t)i;
+        while(r.write.load(std::memory_order_relaxed) - r.read.load(std::memory_order_acquire) >= TEST_RING_SIZE) std::this_thread::yield();
+        uint32_t w = r.write.load(std::memory_order_relaxed);
+        r.blocks[w % TEST_RING_SIZE] = sample;
+        r.write.store(w + 1, std::memory_order_release);
+    }
+    producersDone.fetch_add(1);
+}
+
+
+/**
+ * @brief Check pattern and release blocks
+ */
+static void consumer(int id){
+    ring& r = rings[id];
+    for(;;){
+        uint32_t rd = r.read.load(std::memory_order_relaxed);
+        if(rd == r.write.load(std::memory_order_acquire)){
+            if(producersDone.load() == TEST_PAIRS && rd == r.write.load(std::memory_order_acquire)) break;
+            std::this_thread::yield();
+            continue;
+        }
+        bmp_sample* sample = r.blocks[rd % TEST_RING_SIZE];
+        if(sample->temperature != id || sample->humidity != ~sample->pressure) corrupted.fetch_add(1);
+        r.read.store(rd + 1, std::memory_order_release);
+        moved.fetch_add(1);
+        pool.release(sample);
+    }
+}
+
+
+/**
+ * @brief Short acquire/release cycles competing for the same blocks
+ */
+static void churn(){
+    for(int i = 0; i < TEST_ITERATIONS; i++){
+        bmp_sample* sample = pool.acquire();
+        if(!sample) continue;
+        sample->temperature = -1;
+        pool.release(sample);
+    }
+}
+
+
+/**
+ * @brief Counters must stay within the pool size while everything runs
+ */
+static void monitor(){
+    while(producersDone.load() < TEST_PAIRS){
+        if(pool.available() > TEST_POOL_BLOCKS || pool.minAvailable() > TEST_POOL_BLOCKS) badCount.fetch_add(1);
+    }
+}
+
+
+int main(){
+    std::vector<std::thread> threads;
+    for(int i = 0; i < TEST_PAIRS; i++){
+        threads.emplace_back(producer, i);
+        threads.emplace_back(consumer, i);
+        threads.emplace_back(churn);
+    }
+    threads.emplace_back(monitor);
+    for(auto& thread : threads) thread.join();
+
+    CHECK_EQ(corrupted.load(), 0);
+    CHECK_EQ(badCount.load(), 0);
+    CHECK(moved.load() > 0);
+    CHECK_EQ(pool.available(), TEST_POOL_BLOCKS);
+    CHECK(pool.minAvailable() <= TEST_POOL_BLOCKS);
+
+    /*every block comes back exactly once*/
+    std::vector<bmp_sample*> drained;
+    while(bmp_sample* sample = pool.acquire()) drained.push_back(sample);
+    CHECK_EQ(drained.size(), TEST_POOL_BLOCKS);
+    CHECK_EQ(pool.available(), 0);
+    CHECK_EQ(pool.minAvailable(), 0);
+    uint32_t failures = pool.exhausted();
+    CHECK(pool.acquire() == 0);
+    CHECK_EQ(pool.exhausted(), failures + 1);
+    for(bmp_sample* sample : drained) pool.release(sample);
+    CHECK_EQ(pool.available(), TEST_POOL_BLOCKS);
+
+    return testResult("test_pool");
+}
@@ -0,0 +1,123 @@
+/**
+ * @file test_spectrum.cpp
+ * @author Denys Khmil
+ * @brief Host test: bmp_spectrum band energies of tones and DC, and the transform spread over the next frame
+ */
+#include <math.h>
+
+#include "bmp_spectrum.h"
+#include "test.h"
+
+#define TEST_RATE_MHZ   50000
+#define TEST_N          128
+#define TEST_BASE       101325.0
+
+typedef bmp_spectrum<TEST_N> spectrum;
+
+/**
+ * @brief 4..6 Hz, 11..13 Hz, 18..22 Hz (empty) and 2 Hz up to Nyquist
+ */
+static void addBands(spectrum& s){
+    CHECK_EQ(s.addBand(4000, 6000), 0);
+    CHECK_EQ(s.addBand(11000, 13000), 1);
+    CHECK_EQ(s.addBand(18000, 22000), 2);
+    CHECK_EQ(s.addBand(2000, TEST_RATE_MHZ / 2), 3);
+}
+
+
+/**
+ * @brief Q24.8 pressure of the two tone signal at sample i
+ */
+static uint32_t tones(uint32_t i, double a5, double a12){
+    double t = i / (TEST_RATE_MHZ / 1000.0);
+    double pressure = TEST_BASE + a5 * sin(2 * M_PI * 5 * t) + a12 * sin(2 * M_PI * 12 * t + 1.0);
+    return (uint32_t)lround(pressure * BMP_PRESSURE_SCALE);
+}
+
+
+static uint8_t near(float value, double expected, double tolerance){
+    return fabs(value - expected) <= tolerance;
+}
+
+
+int main(){
+    /*5 Hz / 2 Pa and 12 Hz / 0.5 Pa: mean squares 2.0 and 0.125 Pa^2*/
+    {
+        spectrum s(TEST_RATE_MHZ);
+        addBands(s);
+        CHECK_EQ(s.addBand(1000, 2000), 4);
+        CHECK_EQ(s.binOf(5000), 13);
+        CHECK_EQ(s.binOf(TEST_RATE_MHZ), TEST_N / 2);
+        for(uint32_t i = 0; i < 10 * TEST_N; i++){
+            s.push(tones(i, 2.0, 0.5));
+            if(i % TEST_N != TEST_N - 1 || i < 2 * TEST_N) continue;
+            /*frame before the one just completed*/
+            CHECK(near(s.band(0), 2.0, 0.02));
+            CHECK(near(s.band(1), 0.125, 0.003));
+            CHECK(s.band(2) < 1e-4f);
+            CHECK(s.band(4) < 1e-3f);
+            CHECK(near(s.band(3), 2.125, 0.03));
+        }
+        CHECK_EQ(s.frames(), 9);
+    }
+
+    /*tones in separate streams add up in their own bands only*/
+    {
+        spectrum low(TEST_RATE_MHZ);
+        spectrum high(TEST_RATE_MHZ);
+        addBands(low);
+        addBands(high);
+        for(uint32_t i = 0; i < 3 * TEST_N; i++){
+            low.push(tones(i, 2.0, 0.0));
+            high.push(tones(i, 0.0, 0.5));
+        }
+        CHECK(near(low.band(0), 2.0, 0.02));
+        CHECK(low.band(1) < 1e-4f);
+        CHECK(high.band(0) < 1e-4f);
+        CHECK(near(high.band(1), 0.125, 0.003));
+    }
+
+    /*pure DC: pressure is relative to the first sample of a frame, nothing in any band*/
+    {
+        spectrum s(TEST_RATE_MHZ);
+        addBands(s);
+        CHECK_EQ(s.addBand(0, 0), 4);
+        for(uint32_t i = 0; i < 4 * TEST_N; i++) s.push((uint32_t)(TEST_BASE * BMP_PRESSURE_SCALE));
+        CHECK_EQ(s.frames(), 3);
+        for(uint8_t band = 0; band < 5; band++) CHECK(s.band(band) == 0.0f);
+
+        /*a step between frames is DC of the next frame as well*/
+        for(uint32_t i = 0; i < 2 * TEST_N; i++) s.push((uint32_t)((TEST_BASE + 50.0) * BMP_PRESSURE_SCALE));
+        for(uint8_t band = 0; band < 5; band++) CHECK(s.band(band) == 0.0f);
+    }
+
+    /*the transform of a frame finishes late in the next one: the catch-up at the swap has nothing
+      left, so no push does more than its slice*/
+    {
+        const uint32_t butterflies = (TEST_N / 4) * 6;
+        const uint32_t total = butterflies + TEST_N / 2 + 1;
+        const uint32_t slices = (total + TEST_N - 2) / (TEST_N - 1);
+        const uint32_t pushes = (total + slices - 1) / slices;
+        spectrum s(TEST_RATE_MHZ);
+        addBands(s);
+        uint32_t i = 0;
+        for(uint32_t frame = 1; frame <= 5; frame++){
+            while(i < frame * TEST_N + pushes - 1) s.push(tones(i++, 2.0, 0.5));
+            CHECK_EQ(s.frames(), frame - 1);
+            s.push(tones(i++, 2.0, 0.5));
+            CHECK_EQ(s.frames(), frame);
+        }
+        CHECK(pushes > TEST_N / 2);
+        CHECK(pushes < TEST_N);
+
+        /*reset drops the partial frame and the pending transform*/
+        while(i < 7 * TEST_N) s.push(tones(i++, 2.0, 0.5));
+        s.reset();
+        CHECK_EQ(s.frames(), 0);
+        for(uint32_t k = 0; k < TEST_N + pushes; k++) s.push(tones(i++, 2.0, 0.5));
+        CHECK_EQ(s.frames(), 1);
+        CHECK(near(s.band(0), 2.0, 0.02));
+    }
+
+    return testResult("test_spectrum");
+}
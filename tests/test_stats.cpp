@@ -0,0 +1,161 @@
+/**
+ * @file test_stats.cpp
+ * @author Denys Khmil
+ * @brief Host test: bmp_stats min/max/mean/variance against a two pass reference and window rollover
+ */
+#include <math.h>
+#include <vector>
+
+#include "bmp_stats.h"
+#include "test.h"
+
+/**
+ * @brief Two pass mean and sample variance in long double
+ */
+static void reference(const std::vector<int32_t>& values, double* mean, double* variance){
+    long double sum = 0;
+    for(int32_t value : values) sum += value;
+    long double average = sum / values.size();
+    long double m2 = 0;
+    for(int32_t value : values) m2 += (value - average) * (value - average);
+    *mean = (double)average;
+    *variance = (values.size() > 1) ? (double)(m2 / (values.size() - 1)) : 0.0;
+}
+
+
+/**
+ * @brief Statistics of values match the reference
+ */
+static void checkStats(const bmp_running_stats& stats, const std::vector<int32_t>& values){
+    double mean, variance;
+    reference(values, &mean, &variance);
+    int32_t least = INT32_MAX, most = INT32_MIN;
+    for(int32_t value : values){
+        if(value < least) least = value;
+        if(value > most) most = value;
+    }
+    CHECK_EQ(stats.count(), values.size());
+    CHECK_EQ(stats.min(), least);
+    CHECK_EQ(stats.max(), most);
+    CHECK(fabs(stats.mean() - mean) <= 1e-9 * (fabs(mean) + 1.0));
+    CHECK(fabs(stats.variance() - variance) <= 1e-9 * (variance + 1.0));
+}
+
+
+/**
+ * @brief Q24.8 pressure near sea level with noise of a few Pa and a slow drift
+ */
+static bmp_sample sampleAt(uint32_t i, uint32_t* seed){
+    *seed = *seed * 1103515245 + 12345;
+    int32_t noise = (int32_t)((*seed >> 16) % 1025) - 512;
+    bmp_sample sample;
+    sample.temperature = 2150 + (int32_t)(i % 7) - 3;
+    sample.pressure = (uint32_t)(101325 * 256 + noise + (int32_t)(i / 16));
+    sample.humidity = (uint32_t)(45 * 1024 + (*seed >> 20) % 64);
+    return sample;
+}
+
+
+int main(){
+    /*empty and single value*/
+    {
+        bmp_running_stats stats;
+        CHECK_EQ(stats.count(), 0);
+        CHECK(stats.mean() == 0.0);
+        CHECK(stats.variance() == 0.0);
+        CHECK_EQ(stats.min(), INT32_MAX);
+        CHECK_EQ(stats.max(), INT32_MIN);
+        stats.add(-5);
+        CHECK(stats.mean() == -5.0);
+        CHECK(stats.variance() == 0.0);
+        CHECK_EQ(stats.min(), -5);
+        CHECK_EQ(stats.max(), -5);
+    }
+
+    /*exact on known values: 2, 4, 4, 4, 5, 5, 7, 9 has mean 5 and sample variance 32/7*/
+    {
+        bmp_running_stats stats;
+        for(int32_t value : {2, 4, 4, 4, 5, 5, 7, 9}) stats.add(value);
+        CHECK(stats.mean() == 5.0);
+        CHECK(fabs(stats.variance() - 32.0 / 7.0) < 1e-12);
+        CHECK_EQ(stats.min(), 2);
+        CHECK_EQ(stats.max(), 9);
+    }
+
+    /*full int32 range of values and a constant large value*/
+    {
+        bmp_running_stats stats;
+        std::vector<int32_t> values = {INT32_MIN, INT32_MAX, 0, -1, 1};
+        for(int32_t value : values) stats.add(value);
+        checkStats(stats, values);
+        bmp_running_stats constant;
+        for(int i = 0; i < 100000; i++) constant.add(101325 * 256);
+        CHECK(constant.mean() == 101325.0 * 256);
+        CHECK(constant.variance() == 0.0);
+    }
+
+    /*a million Q24.8 pressure samples in one window, no overflow or cancellation*/
+    {
+        bmp_stats stats;
+        std::vector<int32_t> values;
+        uint32_t seed = 1;
+        for(uint32_t i = 0; i < 1000000; i++){
+            bmp_sample sample = sampleAt(i, &seed);
+            stats.add(&sample);
+            values.push_back((int32_t)sample.pressure);
+        }
+        checkStats(stats.pressure(), values);
+        CHECK_EQ(stats.windows(), 0);
+    }
+
+    /*window rollover: last() holds the completed window, the running one restarts*/
+    {
+        const uint32_t window = 1000;
+        bmp_stats stats(window);
+        std::vector<int32_t> temperature, pressure, humidity;
+        uint32_t seed = 7;
+        for(uint32_t i = 0; i < 3 * window + 10; i++){
+            if(i % window == 0){
+                temperature.clear();
+                pressure.clear();
+                humidity.clear();
+            }
+            bmp_sample sample = sampleAt(i, &seed);
+            stats.add(&sample);
+            temperature.push_back(sample.temperature);
+            pressure.push_back((int32_t)sample.pressure);
+            humidity.push_back((int32_t)sample.humidity);
+            if(i % window == window - 1){
+                CHECK_EQ(stats.windows(), i / window + 1);
+                CHECK_EQ(stats.pressure().count(), 0);
+                checkStats(stats.lastTemperature(), temperature);
+                checkStats(stats.lastPressure(), pressure);
+                checkStats(stats.lastHumidity(), humidity);
+            }
+        }
+        CHECK_EQ(stats.windows(), 3);
+        checkStats(stats.temperature(), temperature);
+        checkStats(stats.pressure(), pressure);
+        checkStats(stats.humidity(), humidity);
+        CHECK_EQ(stats.lastPressure().count(), window);
+
+        /*shorter window restarts the running one, completed windows stay*/
+        stats.setWindow(4);
+        CHECK_EQ(stats.pressure().count(), 0);
+        CHECK_EQ(stats.lastPressure().count(), window);
+        for(int i = 0; i < 4; i++){
+            bmp_sample sample = sampleAt(i, &seed);
+            stats.add(&sample);
+        }
+        CHECK_EQ(stats.windows(), 4);
+        CHECK_EQ(stats.lastPressure().count(), 4);
+
+        stats.reset();
+        CHECK_EQ(stats.windows(), 0);
+        CHECK_EQ(stats.pressure().count(), 0);
+        CHECK_EQ(stats.lastPressure().count(), 0);
+        CHECK_EQ(stats.lastPressure().min(), INT32_MAX);
+    }
+
+    return testResult("test_stats");
+}
@@ -0,0 +1,158 @@
+/**
+ * @file test_task.cpp
+ * @author Denys Khmil
+ * @brief Host test: bmp_task acquisition, bus errors and timeouts, fanout to queues, stop()
+ */
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "bmp_task.h"
+#include "bmp280_compensate.h"
+#include "test.h"
+
+#define TEST_PERIOD         2
+#define TEST_BUS_TIMEOUT    20
+#define TEST_RUN_MS         600
+#define TEST_TIMEOUT_EVERY  7       /*read k with k % 50 == 7 never completes*/
+#define TEST_ERROR_EVERY    13      /*read k with k % 50 == 13 ends in a bus error*/
+
+static const uint8_t calibration[24] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17
+};
+
+struct fake_sensor;
+typedef bmp_task<fake_sensor, 3> test_task;
+
+/**
+ * @brief Sensor whose "interrupt" is a thread completing the transfer after 300 us
+ */
+struct fake_sensor{
+    fake_sensor(){
+        bmp280_parseCalibration(calibration, 0, &this->calib);
+        this->task = 0;
+        this->reads.store(0);
+        this->aborted.store(0);
+    }
+
+    ~fake_sensor(){
+        if(this->irq.joinable()) this->irq.join();
+    }
+
+    uint8_t startRead(){
+        if(this->irq.joinable()) this->irq.join();
+        uint32_t k = this->reads.fetch_add(1);
+        test_task* owner = this->task;
+        this->irq = std::thread([k, owner]{
+            std::this_thread::sleep_for(std::chrono::microseconds(300));
+            if(k % 50 == TEST_TIMEOUT_EVERY) return;
+            if(k % 50 == TEST_ERROR_EVERY) owner->busError();
+            else owner->busComplete();
+        });
+        return 0;
+    }
+
+    void finishRead(bmp_raw* raw){
+        raw->temperature = 519888;
+        raw->pressure = 415148;
+        raw->humidity = 0;
+    }
+
+    void abortRead(){
+        this->aborted.fetch_add(1);
+    }
+
+    void compensate(const bmp_raw* raw, bmp_sample* sample){
+        bmp280_compensate(&this->calib, raw, sample);
+    }
+
+    bmp280_calib calib;
+    test_task* task;
+    std::thread irq;
+    std::atomic<uint32_t> reads;
+    std::atomic<uint32_t> aborted;
+};
+
+
+/**
+ * @brief Reads among the first n with k % 50 == residue
+ */
+static uint32_t every(uint32_t n, uint32_t residue){
+    return n / 50 + (n % 50 > residue ? 1 : 0);
+}
+
+
+int main(){
+    fake_sensor sensor;
+    test_task task(&sensor, TEST_PERIOD, TEST_BUS_TIMEOUT);
+    sensor.task = &task;
+
+    bmp_os_static_queue<bmp_sample, 64> every_sample;
+    bmp_os_static_queue<bmp_sample, 64> averaged;
+    bmp_os_static_queue<bmp_sample, 2> unread;
+    CHECK_EQ(task.subscribe(&every_sample, 1), 0);
+    CHECK_EQ(task.subscribe(&averaged, 4, BMP_FANOUT_AVERAGE), 1);
+    CHECK_EQ(task.subscribe(&unread, 1), 2);
+    CHECK_EQ(task.subscribe(&unread, 1), -1);
+
+    bmp_raw raw;
+    bmp_sample expected;
+    sensor.finishRead(&raw);
+    sensor.compensate(&raw, &expected);
+
+    std::atomic<uint8_t> consuming(1);
+    uint32_t received = 0;
+    uint32_t receivedAveraged = 0;
+    uint32_t wrong = 0;
+    std::thread consumer([&]{
+        bmp_sample sample;
+        while(consuming.load()){
+            if(every_sample.receive(&sample, 5)){
+                received++;
+                if(sample.pressure != expected.pressure || sample.temperature != expected.temperature) wrong++;
+            }
+            if(averaged.receive(&sample, 0)){
+                receivedAveraged++;
+                if(sample.pressure != expected.pressure) wrong++;
+            }
+        }
+    });
+
+    CHECK(task.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(TEST_RUN_MS));
+    task.stop();
+
+    /*stop() returns only after the task has finished, no read starts afterwards*/
+    uint32_t reads = sensor.reads.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10 * TEST_PERIOD));
+    CHECK_EQ(sensor.reads.load(), reads);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    consuming.store(0);
+    consumer.join();
+
+    /*every read ends as a sample, an error or a timeout*/
+    CHECK(reads > 100);
+    CHECK_EQ(task.timeouts(), every(reads, TEST_TIMEOUT_EVERY));
+    CHECK_EQ(task.errors(), every(reads, TEST_ERROR_EVERY));
+    CHECK_EQ(task.samples() + task.errors() + task.timeouts(), reads);
+    CHECK_EQ(sensor.aborted.load(), task.timeouts());
+
+    /*each subscriber gets its share, a full queue drops for that subscriber only*/
+    CHECK_EQ(wrong, 0);
+    CHECK_EQ(received + task.drops(0), task.samples());
+    CHECK_EQ(receivedAveraged + task.drops(1), task.samples() / 4);
+    CHECK_EQ(unread.waiting(), 2);
+    CHECK_EQ(task.drops(2), task.samples() - 2);
+    CHECK(task.drops(2) > task.drops(0));
+
+    /*the task can be started again after stop()*/
+    uint32_t samples = task.samples();
+    CHECK(task.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20 * TEST_PERIOD));
+    task.stop();
+    CHECK(task.samples() > samples);
+
+    return testResult("test_task");
+}
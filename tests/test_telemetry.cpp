@@ -0,0 +1,200 @@
+/**
+ * @file test_telemetry.cpp
+ * @author Denys Khmil
+ * @brief Host test: telemetry encoder/decoder round trip, loss, corruption and resynchronization
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "bmp_telemetry.h"
+#include "test.h"
+
+static const uint8_t calibration[24] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17
+};
+static const uint8_t humidityCalibration[7] = {0x6A, 0x01, 0x00, 0x13, 0x2C, 0x03, 0x1E};
+
+/**
+ * @brief Sender side: every frame's sample compensated on board, by absolute frame number
+ */
+struct link{
+    link(uint8_t humidity, uint8_t session, uint8_t frames_per_packet) : encoder(calib(humidity), session, frames_per_packet){
+        this->sensorCalib = calib(humidity);
+    }
+
+    static bmp280_calib calib(uint8_t humidity){
+        bmp280_calib result;
+        bmp280_parseCalibration(calibration, humidity ? humidityCalibration : 0, &result);
+        result.dig_H1 = 75;
+        return result;
+    }
+
+    /**
+     * @brief Add a random frame
+     * @retval Length of a completed packet, 0 while filling
+     */
+    uint16_t add(){
+        bmp_raw raw = {500000 + rand() % 40000, 400000 + rand() % 100000, this->sensorCalib.humidity ? 20000 + rand() % 30000 : 0};
+        bmp_sample sample;
+        bmp280_compensate(&this->sensorCalib, &raw, &sample);
+        this->sent.push_back(sample);
+        return this->encoder.add(&raw);
+    }
+
+    bmp280_calib sensorCalib;
+    bmp_telemetry_encoder encoder;
+    std::vector<bmp_sample> sent;
+};
+
+/**
+ * @brief Ground side: checks every delivered sample against the sender
+ */
+struct ground{
+    ground(const link* _source) : decoder(sink, this){
+        this->source = _source;
+        this->position = 0;
+        this->delivered = 0;
+        this->mismatches = 0;
+        this->outOfOrder = 0;
+    }
+
+    /**
+     * @brief Frame numbers only move forward here, so the 16 bit sequence extends to the absolute one
+     */
+    static void sink(uint16_t sequence, const bmp_sample* sample, void* context){
+        ground* self = (ground*)context;
+        uint32_t absolute = self->position + (uint16_t)(sequence - (uint16_t)self->position);
+        if(self->delivered && absolute < self->position) self->outOfOrder++;
+        self->position = absolute + 1;
+        self->delivered++;
+        if(absolute >= self->source->sent.size() || memcmp(&self->source->sent[absolute], sample, sizeof(bmp_sample))) self->mismatches++;
+    }
+
+    void calibrate(link& from){
+        uint8_t packet[BMP_TELEMETRY_CALIB_SIZE];
+        CHECK_EQ(this->decoder.receive(packet, from.encoder.calibration(packet)), 0);
+    }
+
+    const link* source;
+    bmp_telemetry_decoder decoder;
+    uint32_t position;
+    uint32_t delivered;
+    uint32_t mismatches;
+    uint32_t outOfOrder;
+};
+
+
+/**
+ * @brief Stream with random packet loss and bit errors, calibration resent in mid-packet
+ */
+static void roundTrip(uint8_t humidity, uint8_t frames_per_packet, int loss_percent, int corrupt_percent){
+    srand(humidity * 100 + frames_per_packet);
+    link sender(humidity, 7, frames_per_packet);
+    ground receiver(&sender);
+    receiver.calibrate(sender);
+    CHECK_EQ(sender.encoder.frameSize(), humidity ? BMP_TELEMETRY_FRAME_H_SIZE : BMP_TELEMETRY_FRAME_SIZE);
+
+    const uint32_t frames = 100000;
+    uint32_t corrupted = 0;
+    for(uint32_t i = 0; i < frames; i++){
+        uint16_t length = sender.add();
+        if(i == frames - 1 && !length) length = sender.encoder.flush();
+        uint8_t last = (i == frames - 1);
+        if(length && (last || rand() % 100 >= loss_percent)){
+            std::vector<uint8_t> packet(sender.encoder.packet(), sender.encoder.packet() + length);
+            if(!last && rand() % 100 < corrupt_percent){
+                packet[rand() % length] ^= (uint8_t)(1 << (rand() % 8));
+                corrupted++;
+            }
+            receiver.decoder.receive(packet.data(), length);
+        }
+        if(i % 4999 == 0) receiver.calibrate(sender);
+    }
+
+    CHECK_EQ(receiver.mismatches, 0);
+    CHECK_EQ(receiver.outOfOrder, 0);
+    CHECK_EQ(receiver.delivered, receiver.decoder.frames());
+    CHECK_EQ(receiver.decoder.frames() + receiver.decoder.lost(), frames);
+    CHECK_EQ(receiver.decoder.rejected(), corrupted);
+    if(!loss_percent && !corrupt_percent) CHECK_EQ(receiver.decoder.lost(), 0);
+}
+
+
+int main(){
+    roundTrip(0, 1, 0, 0);
+    roundTrip(0, 8, 0, 0);
+    roundTrip(0, BMP_TELEMETRY_MAX_FRAMES, 0, 0);
+    roundTrip(1, 8, 0, 0);
+    roundTrip(0, 8, 5, 5);
+    roundTrip(1, 3, 10, 10);
+
+    /*calibration between frames of a packet: advertises the next packet, nothing is lost*/
+    {
+        link sender(0, 1, 8);
+        ground receiver(&sender);
+        receiver.calibrate(sender);
+        ground joining(&sender);
+        for(int i = 0; i < 3; i++) CHECK_EQ(sender.add(), 0);
+        receiver.calibrate(sender);
+        joining.calibrate(sender);
+        for(int i = 0; i < 13; i++){
+            uint16_t length = sender.add();
+            if(!length) continue;
+            CHECK_EQ(receiver.decoder.receive(sender.encoder.packet(), length), 8);
+            CHECK_EQ(joining.decoder.receive(sender.encoder.packet(), length), 8);
+        }
+        CHECK_EQ(receiver.decoder.frames(), 16);
+        CHECK_EQ(receiver.decoder.lost(), 0);
+        CHECK_EQ(receiver.decoder.rejected(), 0);
+        CHECK_EQ(joining.decoder.frames(), 16);
+        CHECK_EQ(joining.decoder.lost(), 0);
+        CHECK_EQ(joining.decoder.rejected(), 0);
+        CHECK_EQ(joining.mismatches, 0);
+    }
+
+    /*dropout longer than 32768 frames: resynchronized by late packets, or at once by a calibration*/
+    for(uint8_t recalibrate = 0; recalibrate < 2; recalibrate++){
+        link sender(0, 2, 8);
+        ground receiver(&sender);
+        receiver.calibrate(sender);
+        for(uint32_t i = 0; i < 40000; i++){
+            uint16_t length = sender.add();
+            if(length && i < 80) receiver.decoder.receive(sender.encoder.packet(), length);
+        }
+        if(recalibrate) receiver.calibrate(sender);
+        uint32_t before = receiver.decoder.frames();
+        for(uint32_t i = 0; i < 80; i++){
+            uint16_t length = sender.add();
+            if(length) receiver.decoder.receive(sender.encoder.packet(), length);
+        }
+        uint32_t late = recalibrate ? 0 : BMP_TELEMETRY_RESYNC_LATE - 1;
+        CHECK_EQ(receiver.decoder.rejected(), late);
+        CHECK_EQ(receiver.decoder.frames() - before, 80 - 8 * late);
+        CHECK_EQ(receiver.mismatches, 0);
+    }
+
+    /*new session: data waits for its calibration*/
+    {
+        link sender(0, 3, 1);
+        ground receiver(&sender);
+        receiver.calibrate(sender);
+        sender.add();
+        CHECK_EQ(receiver.decoder.receive(sender.encoder.packet(), BMP_TELEMETRY_HEADER_SIZE + BMP_TELEMETRY_FRAME_SIZE + BMP_TELEMETRY_CRC_SIZE), 1);
+        link restarted(0, 4, 1);
+        receiver.source = &restarted;
+        uint16_t length = restarted.add();
+        CHECK_EQ(receiver.decoder.receive(restarted.encoder.packet(), length), -1);
+        receiver.calibrate(restarted);
+        CHECK_EQ(receiver.decoder.session(), 4);
+        receiver.position = 0;
+        receiver.delivered = 0;
+        length = restarted.add();
+        CHECK_EQ(receiver.decoder.receive(restarted.encoder.packet(), length), 1);
+        CHECK_EQ(receiver.decoder.lost(), 0);
+        CHECK_EQ(receiver.mismatches, 0);
+    }
+
+    return testResult("test_telemetry");
+}
@@ -0,0 +1,302 @@
+/**
+ * @file bmp280_allan.cpp
+ * @author Denys Khmil
+ * @brief Host tool: overlapping Allan deviation of recorded bmp280 pressure streams
+ *
+ * Build: g++ -O2 -std=c++17 -pthread -I.. bmp280_allan.cpp ../bmp280_compensate.cpp ../bmp280_model.cpp -o bmp280_allan
+ *
+ * Usage: bmp280_allan [options] LOG
+ *   --rate HZ       sample rate of the log (default 1)
+ *   --osrs N        pressure oversampling used while recording, 1..16 (default 1)
+ *   --calib FILE    calibration registers as hex bytes: 24 from 0x88 (bmp280),
+ *                   or 26 from 0x88 followed by 7 from 0xE1 (BME280).
+ *                   With --calib the log holds "raw_t raw_p" per line,
+ *                   without it the last column of each line is pressure in Pa
+ *   --target PA     noise floor to reach, enables the configuration recommendation
+ *   --threads N     worker threads (default: all cores)
+ * Lines starting with '#' are ignored, columns are separated by spaces, tabs or commas.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "bmp280_compensate.h"
+#include "bmp280_model.h"
+#include "bmp280_tool.h"
+
+struct allan_point{
+    double tau;
+    double adev;
+    uint64_t terms;
+};
+
+struct allan_config{
+    uint8_t osrs_p;
+    uint8_t filter;
+    uint8_t t_sb;
+    double period_ms;
+    double noise;
+    double current_ua;
+    double latency_ms;
+};
+
+static const uint8_t osrsCodes[5] = {1, 2, 4, 8, 16};
+static const uint8_t filterCoefficients[5] = {1, 2, 4, 8, 16};
+
+/**
+ * @brief Parse log lines into columns
+ * @param columns: 2 for raw logs (raw_t, raw_p), 1 for pressure logs (last column).
+ */
+static void parseLog(const char* data, size_t length, int columns, std::vector<double>* first, std::vector<double>* last){
+    const char* p = data;
+    const char* end = data + length;
+    first->reserve(length / 16);
+    last->reserve(length / 16);
+    while(p < end){
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if(!eol) eol = end;
+        if(*p != '#'){
+            double values[8];
+            int n = 0;
+            const char* q = p;
+            while(q < eol && n < 8){
+                while(q < eol && (*q == ' ' || *q == '\t' || *q == ',' || *q == '\r')) q++;
+                if(q >= eol) break;
+                char* next;
+                values[n] = strtod(q, &next);
+                if(next == q) break;
+                n++;
+                q = next;
+            }
+            if(n >= columns){
+                if(columns == 2) first->push_back(values[0]);
+                last->push_back(values[n - 1]);
+            }
+        }
+        p = eol + 1;
+    }
+}
+
+
+/**
+ * @brief Run body(begin, end) over [0, count) split across threads
+ */
+template<typename Body>
+static void parallelFor(size_t count, unsigned threads, Body body){
+    std::vector<std::thread> workers;
+    size_t chunk = (count + threads - 1) / threads;
+    for(unsigned t = 0; t < threads; t++){
+        size_t begin = t * chunk;
+        size_t end = std::min(count, begin + chunk);
+        if(begin >= end) break;
+        workers.emplace_back(body, t, begin, end);
+    }
+    for(auto& worker : workers) worker.join();
+}
+
+
+/**
+ * @brief Overlapping Allan deviation at octave spaced averaging factors
+ * @param y: samples (Pa).
+ * @param tau0: sample period (s).
+ * @note Phase x is the running sum of (y - mean), so every term is x[j+2m] - 2x[j+m] + x[j].
+ *       Each thread scans its own contiguous range of j for all m
+ */
+static std::vector<allan_point> allanDeviation(const std::vector<double>& y, double tau0, unsigned threads){
+    size_t n = y.size();
+    std::vector<allan_point> result;
+    if(n < 3) return result;
+
+    double mean = 0.0;
+    for(double v : y) mean += v;
+    mean /= n;
+    std::vector<double> x(n + 1);
+    x[0] = 0.0;
+    for(size_t i = 0; i < n; i++) x[i + 1] = x[i] + (y[i] - mean);
+
+    std::vector<size_t> factors;
+    for(size_t m = 1; 2 * m <= n - 1; m *= 2) factors.push_back(m);
+
+    size_t terms_max = n + 1 - 2;
+    std::vector<std::vector<double> > partial(threads, std::vector<double>(factors.size(), 0.0));
+    parallelFor(terms_max, threads, [&](unsigned t, size_t begin, size_t end){
+        for(size_t k = 0; k < factors.size(); k++){
+            size_t m = factors[k];
+            size_t stop = std::min(end, n + 1 - 2 * m);
+            double sum = 0.0;
+            for(size_t j = begin; j < stop; j++){
+                double d = x[j + 2 * m] - 2.0 * x[j + m] + x[j];
+                sum += d * d;
+            }
+            partial[t][k] = sum;
+        }
+    });
+
+    for(size_t k = 0; k < factors.size(); k++){
+        size_t m = factors[k];
+        uint64_t terms = n + 1 - 2 * m;
+        double sum = 0.0;
+        for(unsigned t = 0; t < threads; t++) sum += partial[t][k];
+        allan_point point;
+        point.tau = m * tau0;
+        point.adev = sqrt(sum / (2.0 * (double)m * (double)m * terms));
+        point.terms = terms;
+        result.push_back(point);
+    }
+    return result;
+}
+
+
+/**
+ * @brief Log-log interpolation of the Allan deviation curve
+ */
+static double interpolate(const std::vector<allan_point>& curve, double tau){
+    if(tau <= curve.front().tau) return curve.front().adev;
+    if(tau >= curve.back().tau) return curve.back().adev;
+    for(size_t i = 1; i < curve.size(); i++){
+        if(tau <= curve[i].tau){
+            double f = log(tau / curve[i - 1].tau) / log(curve[i].tau / curve[i - 1].tau);
+            return exp(log(curve[i - 1].adev) + f * log(curve[i].adev / curve[i - 1].adev));
+        }
+    }
+    return curve.back().adev;
+}
+
+
+/**
+ * @brief Predict noise, current and latency of every normal mode configuration
+ * @note White noise of a single conversion is ADEV(tau0) * sqrt(osrs of the log). A configuration
+ *       averages osrs_p conversions per sample and its IIR filter 2c-1 samples (white noise
+ *       equivalent). The flicker floor (minimum of the curve) and the random walk part (curve past
+ *       its minimum, at the effective averaging time) bound the prediction from below.
+ *       Temperature oversampling is x1, current and timing come from bmp280_model
+ */
+static std::vector<allan_config> predictConfigs(const std::vector<allan_point>& curve, double tau0, int osrs_log){
+    std::vector<allan_config> configs;
+    double sigma1 = curve.front().adev * sqrt((double)osrs_log);
+    size_t min_index = 0;
+    for(size_t i = 1; i < curve.size(); i++){
+        if(curve[i].adev < curve[min_index].adev) min_index = i;
+    }
+    double floor_adev = curve[min_index].adev;
+
+    for(int o = 0; o < 5; o++){
+        for(int f = 0; f < 5; f++){
+            for(int s = 0; s < 8; s++){
+                allan_config config;
+                double period_ms = bmp280_samplePeriod((uint8_t)(o + 1), 0b001, (uint8_t)s) / 1000.0;
+                double samples = 2.0 * filterCoefficients[f] - 1.0;
+                double tau_eff = period_ms * samples / 1000.0;
+
+                double noise = sigma1 / sqrt(osrsCodes[o] * samples);
+                noise = std::max(noise, floor_adev);
+                if(tau_eff > curve[min_index].tau && tau_eff >= tau0) noise = std::max(noise, interpolate(curve, tau_eff));
+
+                config.osrs_p = (uint8_t)(o + 1);
+                config.filter = (uint8_t)f;
+                config.t_sb = (uint8_t)s;
+                config.period_ms = period_ms;
+                config.noise = noise;
+                config.current_ua = bmp280_averageCurrent((uint8_t)(o + 1), 0b001, (uint8_t)s) / 1000.0;
+                config.latency_ms = bmp280_filterSettleSamples((uint8_t)f) * config.period_ms;
+                configs.push_back(config);
+            }
+        }
+    }
+    return configs;
+}
+
+
+int main(int argc, char** argv){
+    double rate = 1.0;
+    double target = 0.0;
+    int osrs_log = 1;
+    const char* calib_path = 0;
+    const char* log_path = 0;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "--rate") && i + 1 < argc) rate = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--target") && i + 1 < argc) target = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--osrs") && i + 1 < argc) osrs_log = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--calib") && i + 1 < argc) calib_path = argv[++i];
+        else if(!strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+        else log_path = argv[i];
+    }
+    if(!log_path || rate <= 0.0 || osrs_log < 1){
+        fprintf(stderr, "usage: %s [--rate HZ] [--osrs N] [--calib FILE] [--target PA] [--threads N] LOG\n", argv[0]);
+        return 1;
+    }
+
+    bmp280_calib calib;
+    if(calib_path && !loadCalibration(calib_path, &calib)){
+        fprintf(stderr, "cannot read calibration %s\n", calib_path);
+        return 1;
+    }
+
+    size_t length = 0;
+    const char* data = mapFile(log_path, &length);
+    if(!data){
+        fprintf(stderr, "cannot map %s\n", log_path);
+        return 1;
+    }
+    std::vector<double> temperature_raw, pressure;
+    parseLog(data, length, calib_path ? 2 : 1, &temperature_raw, &pressure);
+    munmap((void*)data, length);
+
+    if(calib_path){
+        parallelFor(pressure.size(), threads, [&](unsigned, size_t begin, size_t end){
+            bmp280_calib local = calib;
+            for(size_t i = begin; i < end; i++){
+                bmp_raw raw = {(int32_t)temperature_raw[i], (int32_t)pressure[i], 0};
+                bmp_sample sample;
+                bmp280_compensate(&local, &raw, &sample);
+                pressure[i] = sample.pressure / BMP_PRESSURE_SCALE;
+            }
+        });
+    }
+
+    double tau0 = 1.0 / rate;
+    std::vector<allan_point> curve = allanDeviation(pressure, tau0, threads);
+    if(curve.empty()){
+        fprintf(stderr, "not enough samples\n");
+        return 1;
+    }
+
+    printf("# %zu samples, tau0 %.6g s\n", pressure.size(), tau0);
+    printf("# tau_s\tadev_pa\tterms\n");
+    for(const allan_point& point : curve){
+        printf("%.6g\t%.6g\t%llu\n", point.tau, point.adev, (unsigned long long)point.terms);
+    }
+    if(target <= 0.0) return 0;
+
+    std::vector<allan_config> configs = predictConfigs(curve, tau0, osrs_log);
+    std::vector<allan_config> reachable;
+    for(const allan_config& config : configs){
+        if(config.noise <= target) reachable.push_back(config);
+    }
+    if(reachable.empty()){
+        double best = configs.front().noise;
+        for(const allan_config& config : configs) best = std::min(best, config.noise);
+        printf("# target %.4g Pa not reachable, best predicted noise %.4g Pa\n", target, best);
+        return 2;
+    }
+    std::sort(reachable.begin(), reachable.end(), [](const allan_config& a, const allan_config& b){
+        if(a.current_ua != b.current_ua) return a.current_ua < b.current_ua;
+        return a.latency_ms < b.latency_ms;
+    });
+
+    printf("# recommendations for %.4g Pa, lowest current first (osrs_t x1, normal mode)\n", target);
+    printf("# osrs_p\tfilter\tt_sb\todr_hz\tnoise_pa\tcurrent_ua\tlatency_ms\n");
+    for(size_t i = 0; i < reachable.size() && i < 5; i++){
+        const allan_config& c = reachable[i];
+        printf("x%d\t%d\t%d\t%.4g\t%.4g\t%.4g\t%.4g\n", osrsCodes[c.osrs_p - 1], c.filter ? filterCoefficients[c.filter] : 0,
+               c.t_sb, 1000.0 / c.period_ms, c.noise, c.current_ua, c.latency_ms);
+    }
+    return 0;
+}
@@ -0,0 +1,305 @@
+/**
+ * @file bmp280_archive.cpp
+ * @author Denys Khmil
+ * @brief Host tool: time-indexed archive of raw bmp280 frames with per-block summaries
+ *
+ * Build: g++ -O2 -std=c++17 -I.. bmp280_archive.cpp ../bmp280_compensate.cpp -o bmp280_archive
+ *
+ * Usage: bmp280_archive build --calib FILE LOG ARCHIVE
+ *            LOG holds "time_ms raw_t raw_p" per line (time increasing), '#' lines are ignored
+ *        bmp280_archive info ARCHIVE
+ *        bmp280_archive stats ARCHIVE FROM_MS TO_MS      count, min, max, mean pressure
+ *        bmp280_archive drop ARCHIVE FROM_MS TO_MS       largest pressure drop (earlier max - later min)
+ *        bmp280_archive plot ARCHIVE FROM_MS TO_MS N     N buckets of min/mean/max pressure
+ *
+ * File layout (little-endian, every part aligned to the block size):
+ *   header block | data blocks | sparse index (first time of every block)
+ * A data block starts with its time range, frame count and compensated pressure
+ * min/max/sum, followed by 7 byte frames: time delta in ms (uint16) and the 20 bit raw
+ * temperature and pressure packed into 40 bits. Queries binary search the index and read
+ * the summaries of blocks wholly inside the range; only the edge blocks are decoded.
+ * The archive is memory-mapped, blocks are read in place.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "bmp280_compensate.h"
+#include "bmp280_tool.h"
+#include "bmp280_archive.h"
+
+struct frame{
+    uint64_t time;
+    bmp_raw raw;
+};
+
+/**
+ * @brief Pressure summary of a time range
+ */
+struct range_stats{
+    uint64_t count;
+    uint32_t min;
+    uint32_t max;
+    int64_t sum;
+
+    void add(uint32_t pressure){
+        if(!this->count || pressure < this->min) this->min = pressure;
+        if(!this->count || pressure > this->max) this->max = pressure;
+        this->sum += pressure;
+        this->count++;
+    }
+
+    void add(const block_header* block){
+        if(!this->count || block->pressureMin < this->min) this->min = block->pressureMin;
+        if(!this->count || block->pressureMax > this->max) this->max = block->pressureMax;
+        this->sum += block->pressureSum;
+        this->count += block->count;
+    }
+};
+
+/**
+ * @brief Visit a time range: summaries of inner blocks, decoded samples of edge blocks
+ * @param inner: called as inner(block) for blocks wholly inside [from, to].
+ * @param edge: called as edge(time_ms, sample) for samples of the other blocks inside [from, to].
+ * @retval Number of blocks decoded
+ */
+template<typename Inner, typename Edge>
+static uint64_t visitRange(const archive& file, uint64_t from, uint64_t to, Inner inner, Edge edge){
+    const uint64_t* begin = file.index;
+    const uint64_t* end = file.index + file.header->blockCount;
+    uint64_t first = std::upper_bound(begin, end, from) - begin;
+    if(first) first--;
+    uint64_t decoded = 0;
+    for(uint64_t i = first; i < file.header->blockCount && file.index[i] <= to; i++){
+        const block_header* block = file.block(i);
+        if(block->lastTime < from) continue;
+        if(block->firstTime >= from && block->lastTime <= to){
+            inner(block);
+            continue;
+        }
+        decoded++;
+        decodeBlock(file, block, [&](uint64_t time, const bmp_sample& sample){
+            if(time >= from && time <= to) edge(time, sample);
+        });
+    }
+    return decoded;
+}
+
+
+/**
+ * @brief Parse "time_ms raw_t raw_p" lines
+ */
+static void parseFrames(const char* data, size_t length, std::vector<frame>* frames){
+    const char* p = data;
+    const char* end = data + length;
+    frames->reserve(length / 20);
+    while(p < end){
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if(!eol) eol = end;
+        if(*p != '#'){
+            uint64_t values[3];
+            int n = 0;
+            const char* q = p;
+            while(q < eol && n < 3){
+                while(q < eol && (*q == ' ' || *q == '\t' || *q == ',' || *q == '\r')) q++;
+                if(q >= eol) break;
+                char* next;
+                values[n] = strtoull(q, &next, 10);
+                if(next == q) break;
+                n++;
+                q = next;
+            }
+            if(n == 3){
+                frame f;
+                f.time = values[0];
+                f.raw.temperature = (int32_t)values[1];
+                f.raw.pressure = (int32_t)values[2];
+                f.raw.humidity = 0;
+                frames->push_back(f);
+            }
+        }
+        p = eol + 1;
+    }
+}
+
+
+/**
+ * @brief Build archive from a raw log
+ */
+static int build(const char* calib_path, const char* log_path, const char* out_path){
+    archive_header header;
+    memset(&header, 0, sizeof(header));
+    bmp280_calib calib;
+    int calib_count = 0;
+    if(!loadCalibration(calib_path, &calib, header.calib, &calib_count)){
+        fprintf(stderr, "cannot read calibration %s\n", calib_path);
+        return 1;
+    }
+    size_t length;
+    const char* data = mapFile(log_path, &length);
+    if(!data){
+        fprintf(stderr, "cannot read %s\n", log_path);
+        return 1;
+    }
+    std::vector<frame> frames;
+    parseFrames(data, length, &frames);
+    munmap((void*)data, length);
+
+    FILE* out = fopen(out_path, "wb");
+    if(!out){
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return 1;
+    }
+    std::vector<uint8_t> block(ARCHIVE_BLOCK_SIZE);
+    std::vector<uint64_t> index;
+    fwrite(block.data(), 1, ARCHIVE_BLOCK_SIZE, out);
+
+    /*the index is binary searched: every frame is checked against the last one written, also across blocks*/
+    size_t i = 0;
+    uint64_t previous = frames.empty() ? 0 : frames[0].time;
+    while(i < frames.size()){
+        if(frames[i].time < previous){
+            fprintf(stderr, "frame %zu: time goes backwards (%" PRIu64 " after %" PRIu64 "), stopping\n", i + 1, frames[i].time, previous);
+            break;
+        }
+        std::fill(block.begin(), block.end(), 0);
+        block_header* summary = (block_header*)block.data();
+        uint8_t* body = block.data() + sizeof(block_header);
+        summary->firstTime = frames[i].time;
+        previous = frames[i].time;
+        while(i < frames.size() && summary->count < ARCHIVE_FRAMES_PER_BLOCK){
+            const frame& f = frames[i];
+            if(f.time < previous || f.time - previous > ARCHIVE_MAX_DELTA) break;
+            bmp_sample sample;
+            bmp280_compensate(&calib, &f.raw, &sample);
+            if(!summary->count || sample.pressure < summary->pressureMin) summary->pressureMin = sample.pressure;
+            if(!summary->count || sample.pressure > summary->pressureMax) summary->pressureMax = sample.pressure;
+            if(!summary->count || sample.temperature < summary->temperatureMin) summary->temperatureMin = sample.temperature;
+            if(!summary->count || sample.temperature > summary->temperatureMax) summary->temperatureMax = sample.temperature;
+            summary->pressureSum += sample.pressure;
+            packFrame(&body[summary->count * ARCHIVE_FRAME_SIZE], (uint16_t)(f.time - previous), &f.raw);
+            summary->lastTime = f.time;
+            summary->count++;
+            previous = f.time;
+            i++;
+        }
+        index.push_back(summary->firstTime);
+        fwrite(block.data(), 1, ARCHIVE_BLOCK_SIZE, out);
+    }
+
+    header.magic = ARCHIVE_MAGIC;
+    header.blockSize = ARCHIVE_BLOCK_SIZE;
+    header.calibCount = (uint32_t)calib_count;
+    header.blockCount = index.size();
+    header.frameCount = i;
+    header.indexOffset = (uint64_t)(index.size() + 1) * ARCHIVE_BLOCK_SIZE;
+    fwrite(index.data(), sizeof(uint64_t), index.size(), out);
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+    fclose(out);
+    printf("%zu frames in %zu blocks (%zu bytes per frame)\n", i, index.size(),
+           index.empty() ? (size_t)0 : (index.size() + 1) * ARCHIVE_BLOCK_SIZE / i);
+    return 0;
+}
+
+
+static void printPressure(const char* label, uint32_t pressure){
+    printf("%s\t%.2f\n", label, pressure / BMP_PRESSURE_SCALE);
+}
+
+
+int main(int argc, char** argv){
+    if(argc >= 6 && !strcmp(argv[1], "build") && !strcmp(argv[2], "--calib")){
+        return build(argv[3], argv[4], argv[5]);
+    }
+    if(argc < 3){
+        fprintf(stderr, "usage: bmp280_archive build --calib FILE LOG ARCHIVE | info ARCHIVE |\n"
+                        "       stats|drop ARCHIVE FROM_MS TO_MS | plot ARCHIVE FROM_MS TO_MS N\n");
+        return 1;
+    }
+    archive file;
+    if(!openArchive(argv[2], &file)){
+        fprintf(stderr, "cannot open archive %s\n", argv[2]);
+        return 1;
+    }
+    const archive_header* h = file.header;
+    uint64_t from = (argc > 3) ? strtoull(argv[3], 0, 10) : 0;
+    uint64_t to = (argc > 4) ? strtoull(argv[4], 0, 10) : UINT64_MAX;
+
+    if(!strcmp(argv[1], "info")){
+        printf("frames\t%" PRIu64 "\nblocks\t%" PRIu64 "\n", h->frameCount, h->blockCount);
+        if(h->blockCount){
+            printf("first_ms\t%" PRIu64 "\nlast_ms\t%" PRIu64 "\n", file.block(0)->firstTime, file.block(h->blockCount - 1)->lastTime);
+        }
+        return 0;
+    }
+
+    if(!strcmp(argv[1], "stats")){
+        range_stats stats = {0, 0, 0, 0};
+        uint64_t decoded = visitRange(file, from, to, [&](const block_header* block){ stats.add(block); },
+                                      [&](uint64_t, const bmp_sample& sample){ stats.add(sample.pressure); });
+        printf("count\t%" PRIu64 "\n", stats.count);
+        if(stats.count){
+            printPressure("min_pa", stats.min);
+            printPressure("max_pa", stats.max);
+            printf("mean_pa\t%.2f\n", (double)stats.sum / stats.count / BMP_PRESSURE_SCALE);
+        }
+        printf("decoded_blocks\t%" PRIu64 "\n", decoded);
+        return 0;
+    }
+
+    if(!strcmp(argv[1], "drop")){
+        /*branch and bound: a block is decoded only if its summary could beat the best drop*/
+        uint32_t running_max = 0;
+        uint32_t best = 0;
+        uint8_t seen = 0;
+        uint64_t decoded = 0;
+        auto sample_step = [&](uint64_t, const bmp_sample& sample){
+            if(seen && running_max > sample.pressure) best = std::max(best, running_max - sample.pressure);
+            if(!seen || sample.pressure > running_max) running_max = sample.pressure;
+            seen = 1;
+        };
+        decoded += visitRange(file, from, to, [&](const block_header* block){
+            uint32_t bound = std::max(seen ? running_max : 0, block->pressureMax);
+            if(bound > block->pressureMin && bound - block->pressureMin > best){
+                decoded++;
+                decodeBlock(file, block, sample_step);
+                return;
+            }
+            if(!seen || block->pressureMax > running_max) running_max = block->pressureMax;
+            seen = 1;
+        }, sample_step);
+        printf("drop_pa\t%.2f\ndecoded_blocks\t%" PRIu64 "\n", best / BMP_PRESSURE_SCALE, decoded);
+        return 0;
+    }
+
+    if(!strcmp(argv[1], "plot") && argc >= 6){
+        uint64_t points = strtoull(argv[5], 0, 10);
+        if(!points || to <= from) return 1;
+        uint64_t width = (to - from) / points + 1;
+        std::vector<range_stats> buckets(points, range_stats{0, 0, 0, 0});
+        uint64_t decoded = visitRange(file, from, to, [&](const block_header* block){
+            uint64_t b0 = (block->firstTime - from) / width;
+            uint64_t b1 = (block->lastTime - from) / width;
+            if(b0 == b1){
+                buckets[b0].add(block);
+                return;
+            }
+            decodeBlock(file, block, [&](uint64_t time, const bmp_sample& sample){ buckets[(time - from) / width].add(sample.pressure); });
+        }, [&](uint64_t time, const bmp_sample& sample){ buckets[(time - from) / width].add(sample.pressure); });
+        printf("# time_ms\tmin_pa\tmean_pa\tmax_pa\t(decoded blocks: %" PRIu64 ")\n", decoded);
+        for(uint64_t b = 0; b < points; b++){
+            if(!buckets[b].count) continue;
+            printf("%" PRIu64 "\t%.2f\t%.2f\t%.2f\n", from + b * width, buckets[b].min / BMP_PRESSURE_SCALE,
+                   (double)buckets[b].sum / buckets[b].count / BMP_PRESSURE_SCALE, buckets[b].max / BMP_PRESSURE_SCALE);
+        }
+        return 0;
+    }
+
+    fprintf(stderr, "unknown command %s\n", argv[1]);
+    return 1;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file bmp280_archive.h
+ * @author Denys Khmil
+ * @brief This file contents the block archive format shared by the host tools
+ * @note Layout: header block | data blocks | sparse index (first time of every block), see bmp280_archive.cpp
+ */
+#ifndef BMP280_ARCHIVE
+#define BMP280_ARCHIVE
+
+#include <stdint.h>
+#include <string.h>
+
+#include "bmp280_compensate.h"
+#include "bmp280_tool.h"
+
+/*FORMAT*/
+#define ARCHIVE_MAGIC           0x3041504D42ULL
+#define ARCHIVE_BLOCK_SIZE      4096
+#define ARCHIVE_FRAME_SIZE      7
+#define ARCHIVE_MAX_DELTA       0xFFFF
+
+struct archive_header{
+    uint64_t magic;
+    uint32_t blockSize;
+    uint32_t calibCount;
+    uint64_t blockCount;
+    uint64_t frameCount;
+    uint64_t indexOffset;
+    uint8_t calib[BMP280_TOOL_CALIB_MAX];
+};
+
+struct block_header{
+    uint64_t firstTime;
+    uint64_t lastTime;
+    uint32_t count;
+    uint32_t pressureMin;
+    uint32_t pressureMax;
+    int32_t temperatureMin;
+    int64_t pressureSum;
+    int32_t temperatureMax;
+    uint32_t reserved;
+};
+
+#define ARCHIVE_FRAMES_PER_BLOCK ((ARCHIVE_BLOCK_SIZE - sizeof(block_header)) / ARCHIVE_FRAME_SIZE)
+
+/**
+ * @brief Mapped archive
+ */
+struct archive{
+    const char* data;
+    size_t length;
+    const archive_header* header;
+    const uint64_t* index;
+    bmp280_calib calib;
+
+    const block_header* block(uint64_t i) const{
+        return (const block_header*)(this->data + (i + 1) * this->header->blockSize);
+    }
+};
+
+
+/**
+ * @brief Frame encoding
+ */
+static inline void packFrame(uint8_t* out, uint16_t delta, const bmp_raw* raw){
+    uint64_t bits = ((uint64_t)(raw->temperature & 0xFFFFF) << 20)|(uint64_t)(raw->pressure & 0xFFFFF);
+    out[0] = (uint8_t)delta;
+    out[1] = (uint8_t)(delta >> 8);
+    for(int i = 0; i < 5; i++) out[2 + i] = (uint8_t)(bits >> (8 * i));
+}
+
+static inline uint16_t unpackFrame(const uint8_t* in, bmp_raw* raw){
+    uint64_t bits = 0;
+    for(int i = 0; i < 5; i++) bits |= (uint64_t)in[2 + i] << (8 * i);
+    raw->temperature = (int32_t)((bits >> 20) & 0xFFFFF);
+    raw->pressure = (int32_t)(bits & 0xFFFFF);
+    raw->humidity = 0;
+    return (uint16_t)(in[0]|(in[1] << 8));
+}
+
+
+/**
+ * @brief Decode every frame of a block
+ * @param body: called as body(time_ms, sample) in time order.
+ */
+template<typename Body>
+static inline void decodeBlock(const archive& file, const block_header* block, Body body){
+    bmp280_calib calib = file.calib;
+    const uint8_t* frames = (const uint8_t*)(block + 1);
+    uint64_t time = block->firstTime;
+    for(uint32_t i = 0; i < block->count; i++){
+        bmp_raw raw;
+        bmp_sample sample;
+        time += unpackFrame(&frames[i * ARCHIVE_FRAME_SIZE], &raw);
+        bmp280_compensate(&calib, &raw, &sample);
+        body(time, sample);
+    }
+}
+
+
+/**
+ * @brief Check the header, the index and every block header of a mapped archive
+ * @note Blocks must hold at most ARCHIVE_FRAMES_PER_BLOCK frames, span firstTime..lastTime in
+ *       time order and match their index entry, the frame counts must add up to frameCount
+ * @retval 1 if valid
+ */
+static inline int validArchive(archive* file){
+    if(file->length < ARCHIVE_BLOCK_SIZE) return 0;
+    file->header = (const archive_header*)file->data;
+    const archive_header* h = file->header;
+    if(h->magic != ARCHIVE_MAGIC || h->blockSize != ARCHIVE_BLOCK_SIZE) return 0;
+    if(h->blockCount >= file->length / h->blockSize || h->indexOffset < (h->blockCount + 1) * h->blockSize) return 0;
+    if(h->indexOffset > file->length || h->blockCount * sizeof(uint64_t) > file->length - h->indexOffset) return 0;
+    file->index = (const uint64_t*)(file->data + h->indexOffset);
+
+    uint64_t frames = 0;
+    for(uint64_t i = 0; i < h->blockCount; i++){
+        const block_header* block = file->block(i);
+        if(block->count > ARCHIVE_FRAMES_PER_BLOCK || block->firstTime > block->lastTime) return 0;
+        if(file->index[i] != block->firstTime) return 0;
+        if(i && block->firstTime < file->block(i - 1)->lastTime) return 0;
+        frames += block->count;
+    }
+    if(frames != h->frameCount) return 0;
+    return parseCalibration(h->calib, (int)h->calibCount, &file->calib);
+}
+
+
+/**
+ * @brief Map and validate archive
+ * @param advice: madvise() hint, random for queries, sequential for full scans.
+ * @retval 1 on success, on failure nothing stays mapped
+ */
+static inline int openArchive(const char* path, archive* file, int advice = MADV_RANDOM){
+    file->data = mapFile(path, &file->length, advice);
+    if(!file->data) return 0;
+    if(!validArchive(file)){
+        munmap((void*)file->data, file->length);
+        file->data = 0;
+        return 0;
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,267 @@
+/**
+ * @file bmp280_reprocess.cpp
+ * @author Denys Khmil
+ * @brief Host tool: parallel re-compensation and filtering of archived raw frames
+ *
+ * Build: g++ -O3 -std=c++17 -pthread -I.. bmp280_reprocess.cpp ../bmp280_compensate.cpp -o bmp280_reprocess
+ *
+ * Usage: bmp280_reprocess [options] ARCHIVE...
+ *   --threads N     worker threads (default: all cores)
+ *   --chunk N       archive blocks per work item (default 64)
+ *   --warmup N      blocks decoded before a work item to settle the filters (default 2)
+ *   --out FILE      write 16 byte records (time_ms uint64, temperature int32, filtered pressure uint32)
+ *   --scaling       run with 1, 2, 4 .. N threads and report the speedup
+ *   --verify        compare against one sequential pass, fail (exit 2) above the tolerance
+ *   --tolerance N   largest difference --verify accepts, LSB of Q24.8 Pa (default 4)
+ *
+ * Archives come from bmp280_archive. Every work item runs its own copy of the filter chain
+ * below over a run of whole blocks, starting --warmup blocks early, so items are independent
+ * and spread over the cores by an atomic counter. Output positions follow from the block
+ * frame counts, so workers write the memory-mapped output in place.
+ * The despike window is exact after warm-up, the fixed-point low-pass state is not: its rounding
+ * residue never decays, so items match one sequential pass to 3 LSB of Q24.8 (0.012 Pa) on the
+ * bench_reprocess week, whatever the warm-up. --verify fails above 4 LSB by default, far below
+ * the sensor noise; a warm-up too short for the filters shows up as hundreds of LSB.
+ */
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "bmp_filter.h"
+#include "bmp_median.h"
+#include "bmp_pipeline.h"
+#include "bmp280_archive.h"
+
+/*VERIFY: largest difference from the sequential pass, LSB of Q24.8 Pa*/
+#define BMP280_REPROCESS_TOLERANCE  4
+
+/*FILTER CHAIN (edit and rebuild to reprocess with a new chain)*/
+typedef bmp_hampel<5> reprocess_despike;
+typedef bmp_butterworth4<50, 1000> reprocess_lowpass;
+
+struct output_record{
+    uint64_t time;
+    int32_t temperature;
+    uint32_t pressure;
+};
+
+/**
+ * @brief Pipeline sink writing to the output from a given position
+ * @note Samples before start are warm-up and dropped
+ */
+struct output_sink{
+    output_record* out;
+    uint64_t skip;
+    uint64_t checksum;
+    uint64_t time;
+
+    void operator()(const bmp_sample& sample){
+        if(this->skip){
+            this->skip--;
+            return;
+        }
+        this->checksum += sample.pressure;
+        if(!this->out) return;
+        this->out->time = this->time;
+        this->out->temperature = sample.temperature;
+        this->out->pressure = sample.pressure;
+        this->out++;
+    }
+};
+
+typedef bmp_pipeline<bmp_filter_stage<reprocess_despike>, bmp_filter_stage<reprocess_lowpass>,
+                     bmp_publish_stage<output_sink> > reprocess_chain;
+
+/**
+ * @brief Run of blocks of one archive
+ */
+struct work_item{
+    uint32_t file;
+    uint64_t first;
+    uint64_t last;
+    uint64_t output;
+};
+
+/**
+ * @brief Process one work item with a fresh chain
+ * @retval Checksum of the filtered pressure
+ */
+static uint64_t processItem(const archive& file, const work_item& item, uint64_t warmup, output_record* out){
+    reprocess_chain chain;
+    uint64_t start = (item.first > warmup) ? item.first - warmup : 0;
+    output_sink& sink = chain.stage<2>().get();
+    sink.out = out ? out + item.output : 0;
+    sink.skip = 0;
+    sink.checksum = 0;
+    for(uint64_t b = start; b < item.first; b++) sink.skip += file.block(b)->count;
+    for(uint64_t b = start; b < item.last; b++){
+        decodeBlock(file, file.block(b), [&](uint64_t time, const bmp_sample& sample){
+            sink.time = time;
+            chain.push(sample);
+        });
+    }
+    return sink.checksum;
+}
+
+
+/**
+ * @brief Process all items on threads
+ * @retval Checksum of the filtered pressure
+ */
+static uint64_t run(const std::vector<archive>& files, const std::vector<work_item>& items, uint64_t warmup,
+                    unsigned threads, output_record* out){
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> checksum(0);
+    std::vector<std::thread> workers;
+    for(unsigned t = 0; t < threads; t++){
+        workers.emplace_back([&](){
+            uint64_t sum = 0;
+            for(size_t i = next.fetch_add(1); i < items.size(); i = next.fetch_add(1)){
+                sum += processItem(files[items[i].file], items[i], warmup, out);
+            }
+            checksum.fetch_add(sum);
+        });
+    }
+    for(auto& worker : workers) worker.join();
+    return checksum.load();
+}
+
+
+/**
+ * @brief Create output file of records and map it writable
+ */
+static output_record* mapOutput(const char* path, uint64_t records){
+    int fd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if(fd < 0) return 0;
+    size_t length = records * sizeof(output_record);
+    if(!length || ftruncate(fd, length) != 0){
+        close(fd);
+        return 0;
+    }
+    void* data = mmap(0, length, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return (data == MAP_FAILED) ? 0 : (output_record*)data;
+}
+
+
+int main(int argc, char** argv){
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t chunk = 64;
+    uint64_t warmup = 2;
+    const char* out_path = 0;
+    int scaling = 0;
+    int verify = 0;
+    uint32_t tolerance = BMP280_REPROCESS_TOLERANCE;
+    std::vector<const char*> paths;
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+        else if(!strcmp(argv[i], "--chunk") && i + 1 < argc) chunk = std::max(1LL, atoll(argv[++i]));
+        else if(!strcmp(argv[i], "--warmup") && i + 1 < argc) warmup = atoll(argv[++i]);
+        else if(!strcmp(argv[i], "--out") && i + 1 < argc) out_path = argv[++i];
+        else if(!strcmp(argv[i], "--scaling")) scaling = 1;
+        else if(!strcmp(argv[i], "--verify")) verify = 1;
+        else if(!strcmp(argv[i], "--tolerance") && i + 1 < argc) tolerance = (uint32_t)atol(argv[++i]);
+        else paths.push_back(argv[i]);
+    }
+    if(paths.empty()){
+        fprintf(stderr, "usage: bmp280_reprocess [--threads N] [--chunk N] [--warmup N] [--out FILE] [--scaling] [--verify] [--tolerance N] ARCHIVE...\n");
+        return 1;
+    }
+
+    std::vector<archive> files(paths.size());
+    std::vector<work_item> items;
+    uint64_t samples = 0;
+    for(size_t f = 0; f < paths.size(); f++){
+        if(!openArchive(paths[f], &files[f], MADV_SEQUENTIAL)){
+            fprintf(stderr, "cannot open archive %s\n", paths[f]);
+            return 1;
+        }
+        for(uint64_t b = 0; b < files[f].header->blockCount; b += chunk){
+            work_item item;
+            item.file = (uint32_t)f;
+            item.first = b;
+            item.last = std::min(b + chunk, files[f].header->blockCount);
+            item.output = samples;
+            for(uint64_t i = item.first; i < item.last; i++) samples += files[f].block(i)->count;
+            items.push_back(item);
+        }
+    }
+
+    output_record* out = 0;
+    std::vector<output_record> memory;
+    if(out_path){
+        out = mapOutput(out_path, samples);
+        if(!out){
+            fprintf(stderr, "cannot write %s\n", out_path);
+            return 1;
+        }
+    }
+    else if(verify){
+        memory.resize(samples);
+        out = memory.data();
+    }
+
+    printf("# %" PRIu64 " samples in %zu work items\n", samples, items.size());
+    printf("# threads\tsamples_per_s\tper_core\tspeedup\n");
+    std::vector<unsigned> counts;
+    if(scaling){
+        for(unsigned t = 1; t < threads; t *= 2) counts.push_back(t);
+    }
+    counts.push_back(threads);
+    double single = 0.0;
+    uint64_t checksum = 0;
+    for(unsigned t : counts){
+        auto start = std::chrono::steady_clock::now();
+        checksum = run(files, items, warmup, t, out);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double rate = samples / seconds;
+        if(t == 1 || single == 0.0) single = rate / t;
+        printf("%u\t%.4g\t%.4g\t%.2f\n", t, rate, rate / t, rate / single);
+    }
+    printf("# checksum %" PRIu64 "\n", checksum);
+
+    int result = 0;
+    if(verify){
+        /*one chain over each whole archive, in order*/
+        uint64_t mismatches = 0;
+        uint32_t worst = 0;
+        uint64_t position = 0;
+        for(size_t f = 0; f < files.size(); f++){
+            reprocess_chain chain;
+            output_sink& sink = chain.stage<2>().get();
+            std::vector<output_record> reference(1);
+            for(uint64_t b = 0; b < files[f].header->blockCount; b++){
+                decodeBlock(files[f], files[f].block(b), [&](uint64_t time, const bmp_sample& sample){
+                    sink.out = reference.data();
+                    sink.skip = 0;
+                    sink.time = time;
+                    chain.push(sample);
+                    uint32_t diff = (uint32_t)std::abs((int64_t)reference[0].pressure - out[position].pressure);
+                    if(diff){
+                        mismatches++;
+                        worst = std::max(worst, diff);
+                    }
+                    position++;
+                });
+            }
+        }
+        printf("# verify: %" PRIu64 " of %" PRIu64 " samples differ from the sequential pass, worst %u LSB\n",
+               mismatches, samples, worst);
+        if(worst > tolerance){
+            fprintf(stderr, "verify failed: worst difference %u LSB above the tolerance of %u LSB\n", worst, tolerance);
+            result = 2;
+        }
+    }
+    if(out_path) munmap(out, samples * sizeof(output_record));
+    return result;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file bmp280_tool.h
+ * @author Denys Khmil
+ * @brief This file contents the helpers shared by the host tools (file mapping, calibration dumps)
+ */
+#ifndef BMP280_TOOL
+#define BMP280_TOOL
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bmp280_compensate.h"
+
+/*CALIBRATION DUMP*/
+#define BMP280_TOOL_CALIB_MAX (BME280_CALIB_LENGTH + BME280_CALIB_H_LENGTH)
+
+/**
+ * @brief Map whole file read-only
+ * @param advice: madvise() hint (MADV_SEQUENTIAL for scans, MADV_RANDOM for lookups).
+ * @retval Pointer to the content, 0 on error
+ */
+static inline const char* mapFile(const char* path, size_t* length, int advice = MADV_SEQUENTIAL){
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return 0;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0){
+        close(fd);
+        return 0;
+    }
+    void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) return 0;
+    madvise(data, st.st_size, advice);
+    *length = st.st_size;
+    return (const char*)data;
+}
+
+
+/**
+ * @brief Parse calibration registers
+ * @param regs: 24 bytes from 0x88 (bmp280), or 26 from 0x88 followed by 7 from 0xE1 (BME280).
+ * @retval 1 on success
+ */
+static inline int parseCalibration(const uint8_t* regs, int count, bmp280_calib* calib){
+    if(count == BMP280_CALIB_LENGTH){
+        bmp280_parseCalibration(regs, 0, calib);
+        return 1;
+    }
+    if(count == BME280_CALIB_LENGTH + BME280_CALIB_H_LENGTH){
+        bmp280_parseCalibration(regs, &regs[BME280_CALIB_LENGTH], calib);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Parse calibration hex dump
+ * @param regs: copy of the registers (BMP280_TOOL_CALIB_MAX bytes, may be 0).
+ * @param count: number of registers (may be 0).
+ * @retval 1 on success
+ */
+static inline int loadCalibration(const char* path, bmp280_calib* calib, uint8_t* regs = 0, int* count = 0){
+    FILE* file = fopen(path, "r");
+    if(!file) return 0;
+    uint8_t buffer[BMP280_TOOL_CALIB_MAX];
+    unsigned int value;
+    int n = 0;
+    while(n < (int)sizeof(buffer) && fscanf(file, " %x%*[ ,\t\r\n]", &value) == 1){
+        buffer[n++] = (uint8_t)value;
+    }
+    fclose(file);
+    if(!parseCalibration(buffer, n, calib)) return 0;
+    for(int i = 0; regs && i < n; i++) regs[i] = buffer[i];
+    if(count) *count = n;
+    return 1;
+}
+
+#endif